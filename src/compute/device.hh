@@ -2,6 +2,8 @@
 #define TEST_DEVICE_H
 #include "sim_config.hh"
 
+using DeviceId = uint32_t;
+
 enum class DeviceType {
   GPU,
   CPU,
@@ -11,14 +13,13 @@ enum class DeviceType {
 
 class Device {
  public:
-  Device( uint16_t dev_id, DeviceType type ) : dev_id( dev_id ), type( type ) { }
+  Device( DeviceId dev_id, DeviceType type ) : dev_id( dev_id ), type( type ) { }
 
   virtual ~Device( ) { }
 
  public:
-  uint16_t dev_id;
+  DeviceId dev_id;
   DeviceType type;
-  static Step curr_step;
 };
 
 #endif
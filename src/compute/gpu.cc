@@ -12,6 +12,33 @@ ExitStatus GPU::fetch_tx( Packet *&pkt ) {
   return ExitStatus::SUCCESS;
 }
 
+ExitStatus GPU::fetch_tx( PacketQueue &pkts ) {
+  /* called by the interconnect only; takes all the pending packets */
+  pkts.splice_back( tx_buff );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus GPU::fetch_tx( Packet *&pkt, Step sent_by ) {
+  /* called by the interconnect only */
+  if ( tx_buff.empty( ) || tx_buff.front( )->tx_time > sent_by )
+    return ExitStatus::NOT_AVAILABLE;
+  pkt = tx_buff.front( );
+  tx_buff.pop_front( );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus GPU::fetch_tx( PacketQueue &pkts, Step sent_by ) {
+  /* called by the interconnect only; tx_buff is in tx_time order */
+  size_t num_pkts = 0;
+  for ( const Packet *pkt : tx_buff ) {
+    if ( pkt->tx_time > sent_by )
+      break;
+    num_pkts ++;
+  }
+  pkts.splice_back( tx_buff, num_pkts );
+  return ExitStatus::SUCCESS;
+}
+
 ExitStatus GPU::fill_rx( Packet *pkt, uint16_t num_pkts ) {
   /* called by the interconnect only */
   for ( uint16_t i = 0; i < num_pkts; i ++ ) {
@@ -20,7 +47,7 @@ ExitStatus GPU::fill_rx( Packet *pkt, uint16_t num_pkts ) {
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus GPU::packetize( NetOp *op ) {
+ExitStatus GPU::packetize( NetOp *op, Step now ) {
   PacketId num_pkts = 0;
   double rem_byte = op->transfer_bytes;
   if ( rem_byte == 0 ) {
@@ -30,7 +57,7 @@ ExitStatus GPU::packetize( NetOp *op ) {
   }
   while ( rem_byte > 0 ) {
     uint16_t num_bytes = ( rem_byte > Packet::max_pkt_size ? Packet::max_pkt_size : rem_byte );
-    Packet *p = new Packet( op->src_device, op->dst_device, num_bytes, curr_step /* tx_time */ );
+    Packet *p = new Packet( op->src_device, op->dst_device, num_bytes, now /* tx_time */, ctx->num_pkts ++ );
     tp->tp_input.push_back( p );
     rem_byte -= num_bytes;
     num_pkts ++;
@@ -38,11 +65,11 @@ ExitStatus GPU::packetize( NetOp *op ) {
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus GPU::compute( CompOp *op ) {
+ExitStatus GPU::compute( CompOp *op, Step now ) {
   assert( op->type == OpType::COMPUTE );
   assert( op->device->type == DeviceType::GPU );
   assert( op->device->dev_id == dev_id );
-  op->start = ( curr_step < next_available ? next_available : curr_step );
+  op->start = ( now < next_available ? next_available : now );
   auto comp_time = op->comp_time;
   comp_time = ( comp_time > cnfg->gpu_min_comp_time ? comp_time : cnfg->gpu_min_comp_time );
   op->end = op->start + comp_time + cnfg->gpu_launch_latency;
@@ -50,13 +77,13 @@ ExitStatus GPU::compute( CompOp *op ) {
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus GPU::communicate( NetOp *op ) {
+ExitStatus GPU::communicate( NetOp *op, Step now ) {
   //Todo: implement pcie logic
-  packetize( op ).ok( );
+  packetize( op, now ).ok( );
   PacketId last_pkt_id;
   tp->send( last_pkt_id ).ok( );
-  recv_sig.emplace( last_pkt_id, op );
-  op->start = Device::curr_step;
+  ctx->recv_sig.emplace( last_pkt_id, op );
+  op->start = now;
   return ExitStatus::SUCCESS;
 }
 
@@ -68,6 +95,11 @@ ExitStatus GPU::get_avail_memsize( uint64_t &size ) const {
   return ExitStatus::SUCCESS;
 }
 
+ExitStatus GPU::get_total_memsize( uint64_t &size ) const {
+  size = total_memory;
+  return ExitStatus::SUCCESS;
+}
+
 ExitStatus GPU::allocate_mem( Op *op ) {
   uint64_t req_size;
   op->get_mem_size( req_size ).ok( );
@@ -119,7 +151,14 @@ ExitStatus GPU::summary( ) const {
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus GPU::setup_transport( int num_gpus ) {
-  tp = new Transport( tx_buff, rx_buff, num_gpus );
+ExitStatus GPU::join( SimContext &sim_ctx ) {
+  ctx = &sim_ctx;
+  dev_id = ctx->dev_count ++;
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus GPU::setup_transport( ) {
+  assert( ctx != nullptr );
+  tp = new Transport( *ctx, dev_id, tx_buff, rx_buff );
   return ExitStatus::SUCCESS;
 }
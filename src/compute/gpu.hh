@@ -1,6 +1,5 @@
 #ifndef SIPML_SRC_GPU_HH_
 #define SIPML_SRC_GPU_HH_
-#include <deque>
 #include <vector>
 #include <utility>
 #include <map>
@@ -9,13 +8,12 @@
 #include "exit_status.hh"
 #include "op.hh"
 #include "transport.hh"
-
-using NetworkSignal = std::unordered_map< PacketId, Op * >;
+#include "sim_context.hh"
 
 class GPU : public Device {
  private:
-  std::deque< Packet * > tx_buff;
-  std::deque< Packet * > rx_buff;
+  PacketQueue tx_buff;
+  PacketQueue rx_buff;
   Step next_available;
   /* device stats */
   const uint64_t total_memory;
@@ -23,13 +21,11 @@ class GPU : public Device {
   std::map< Op *, uint64_t > mem_map;
   Step load_est;
  public:
-  static uint16_t dev_count;
+  SimContext *ctx;
   Transport *tp;
-  /* a feature to signal when a communication Op is finished */
-  static NetworkSignal recv_sig;
   SimConfig *cnfg;
  public:
-  explicit GPU( ) : Device( dev_count, DeviceType::GPU ),
+  explicit GPU( ) : Device( 0, DeviceType::GPU ),
                     tx_buff( ),
                     rx_buff( ),
                     next_available( 0 ),
@@ -37,9 +33,9 @@ class GPU : public Device {
                     used_memory( 0 ),
                     mem_map( ),
                     load_est( 0 ),
+                    ctx( nullptr ),
                     tp( nullptr ),
                     cnfg( nullptr ){
-    dev_count ++;
   }
 
   GPU( const GPU & ) = delete;
@@ -48,14 +44,24 @@ class GPU : public Device {
 
   ExitStatus fetch_tx( Packet *&pkt );
 
+  ExitStatus fetch_tx( PacketQueue &pkts );
+
+  /* the same, limited to the packets sent up to step sent_by */
+  ExitStatus fetch_tx( Packet *&pkt, Step sent_by );
+
+  ExitStatus fetch_tx( PacketQueue &pkts, Step sent_by );
+
   ExitStatus fill_rx( Packet *pkt, uint16_t num_pkts );
 
-  ExitStatus compute( CompOp *op );
+  /* now is the step of the session launching op */
+  ExitStatus compute( CompOp *op, Step now );
 
-  ExitStatus communicate( NetOp *op );
+  ExitStatus communicate( NetOp *op, Step now );
 
   ExitStatus get_avail_memsize( uint64_t &size ) const;
 
+  ExitStatus get_total_memsize( uint64_t &size ) const;
+
   ExitStatus check_mem_feas( Op *op, bool &is_feas );
 
   ExitStatus allocate_mem( Op *op );
@@ -66,10 +72,13 @@ class GPU : public Device {
 
   ExitStatus summary( ) const;
 
-  ExitStatus setup_transport( int num_gpus );
+  /* become the next gpu of ctx's simulation; before setup_transport( ) */
+  ExitStatus join( SimContext &sim_ctx );
+
+  ExitStatus setup_transport( );
 
  private:
-  ExitStatus packetize( NetOp *op );
+  ExitStatus packetize( NetOp *op, Step now );
 };
 
 #endif //SIPML_SRC_GPU_HH_
@@ -0,0 +1,37 @@
+#ifndef ROSTAM_SRC_COMPUTE_SIM_CONTEXT_HH_
+#define ROSTAM_SRC_COMPUTE_SIM_CONTEXT_HH_
+#include <random>
+#include <unordered_map>
+#include "device.hh"
+#include "packet.hh"
+
+class Op;
+
+using NetworkSignal = std::unordered_map< PacketId, Op * >;
+
+/* State shared by all the devices of one simulation. Each simulation owns
+ * one, and its gpus and their transports point to it ( see GPU::join ),
+ * so independent simulations can run in one process, each on its own
+ * thread. The clocks are kept by the session and the interconnect. */
+class SimContext {
+ public:
+  DeviceId dev_count;   /* gpus joined so far, and the next gpu id */
+  PacketId num_pkts;    /* packets created so far, and the next packet id */
+  /* a feature to signal when a communication Op is finished:
+   * the op completed by each op's last packet */
+  NetworkSignal recv_sig;
+  /* currently assume all packets acks are shared centeralized */
+  std::unordered_map< PacketId, Packet * > flying_pkts;
+  /* the random choices of the interconnect, from the same seed in every
+   * simulation */
+  std::mt19937 rng;
+
+ public:
+  SimContext( ) : dev_count( 0 ), num_pkts( 0 ), recv_sig( ), flying_pkts( ), rng( ) { }
+
+  SimContext( const SimContext & ) = delete;
+
+  SimContext &operator=( const SimContext & ) = delete;
+};
+
+#endif //ROSTAM_SRC_COMPUTE_SIM_CONTEXT_HH_
@@ -1,3 +1,4 @@
+#include <iomanip>
 #include "graph.hh"
 
 using namespace std;
@@ -207,6 +208,213 @@ ExitStatus CG::scale_graph( CG &scaled_graph, const double &batch_factor ) const
   return ExitStatus::SUCCESS;
 }
 
+ExitStatus CG::clone( CG &copy ) const {
+  std::map< Op *, Op * > old_to_new;
+  for ( auto e : adj ) {
+    Op *new_op;
+    switch ( e.first->type ) {
+      case OpType::COMPUTE:new_op = new CompOp( *static_cast<CompOp *>( e.first ));
+        break;
+      case OpType::MEMORY:new_op = new MemOp( *static_cast<MemOp *>( e.first ));
+        break;
+      case OpType::NETWORK:new_op = new NetOp( *static_cast<NetOp *>( e.first ));
+        break;
+      case OpType::CONTROL_DEPENDENCY:new_op = new CntrlOp( *static_cast<CntrlOp *>( e.first ));
+        break;
+      default :throw runtime_error( "Not implemented." );
+    }
+    old_to_new[ e.first ] = new_op;
+    /* keep the ops without any edges */
+    copy.adj[ new_op ];
+    copy.reverse_adj[ new_op ];
+  }
+  for ( auto e : adj ) {
+    for ( auto succ : e.second ) {
+      copy.add_edge( old_to_new.at( e.first ), old_to_new.at( succ ));
+    }
+  }
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus CG::remap_devices( const std::function< Device *( Device * ) > &device_of ) {
+  for ( auto e : adj ) {
+    Op *op = e.first;
+    if ( op->device != nullptr )
+      op->device = device_of( op->device );
+    if ( op->type == OpType::NETWORK ) {
+      auto netop = static_cast<NetOp *>( op );
+      netop->src_device = device_of( netop->src_device );
+      netop->dst_device = device_of( netop->dst_device );
+    }
+  }
+  return ExitStatus::SUCCESS;
+}
+
+static void save_device( std::ostream &out, const Device *device ) {
+  if ( device == nullptr )
+    out << " -1 0";
+  else
+    out << " " << int( device->type ) << " " << device->dev_id;
+}
+
+static bool load_device( std::istream &in,
+                         const std::function< Device *( DeviceType, DeviceId ) > &device_of,
+                         Device *&device ) {
+  int type;
+  DeviceId dev_id;
+  if ( ! ( in >> type >> dev_id ))
+    return false;
+  if ( type == - 1 ) {
+    device = nullptr;
+    return true;
+  }
+  device = device_of( DeviceType( type ), dev_id );
+  return device != nullptr;
+}
+
+ExitStatus CG::save( std::ostream &out ) const {
+  map< Op *, size_t > index;
+  out << "ops " << adj.size( ) << "\n";
+  for ( auto e : adj ) {
+    Op *op = e.first;
+    index.emplace( op, index.size( ));
+    out << int( op->type ) << " " << quoted( op->name ) << " " << quoted( op->creator ) << " "
+        << op->session_id << " " << op->priority;
+    save_device( out, op->device );
+    switch ( op->type ) {
+      case OpType::COMPUTE: {
+        auto comp_op = static_cast<CompOp *>( op );
+        uint16_t bs;
+        comp_op->get_batch_size( bs ).ok( );
+        out << " " << bs << " " << comp_op->comp_time << " " << comp_op->output_bytes
+            << " " << comp_op->comp_time_map.size( );
+        for ( auto ct : comp_op->comp_time_map )
+          out << " " << ct.first << " " << ct.second;
+        out << " " << comp_op->output_bytes_map.size( );
+        for ( auto ob : comp_op->output_bytes_map )
+          out << " " << ob.first << " " << ob.second;
+      }
+        break;
+      case OpType::MEMORY: {
+        auto mem_op = static_cast<MemOp *>( op );
+        out << " " << int( mem_op->mem_type ) << " " << mem_op->num_bytes;
+      }
+        break;
+      case OpType::NETWORK: {
+        auto net_op = static_cast<NetOp *>( op );
+        out << " " << setprecision( numeric_limits< double >::max_digits10 ) << net_op->transfer_bytes;
+        save_device( out, net_op->src_device );
+        save_device( out, net_op->dst_device );
+      }
+        break;
+      case OpType::CONTROL_DEPENDENCY:
+        break;
+    }
+    out << "\n";
+  }
+  size_t num_edges = 0;
+  for ( auto e : adj )
+    num_edges += e.second.size( );
+  out << "edges " << num_edges << "\n";
+  for ( auto e : adj ) {
+    for ( auto succ : e.second )
+      out << index.at( e.first ) << " " << index.at( succ ) << "\n";
+  }
+  return ( out ? ExitStatus::SUCCESS : ExitStatus::FAILURE );
+}
+
+ExitStatus CG::load( std::istream &in, const std::function< Device *( DeviceType, DeviceId ) > &device_of ) {
+  assert( adj.empty( ));
+  vector< Op * > ops;
+  string tag;
+  size_t num_ops = 0;
+  bool good = ( in >> tag >> num_ops ) && tag == "ops";
+  for ( size_t i = 0; good && i < num_ops; i ++ ) {
+    int type;
+    string name;
+    string creator;
+    uint16_t session_id;
+    uint32_t priority;
+    Device *device;
+    good = ( in >> type >> quoted( name ) >> quoted( creator ) >> session_id >> priority )
+        && load_device( in, device_of, device );
+    if ( ! good )
+      break;
+    Op *op = nullptr;
+    switch ( OpType( type )) {
+      case OpType::COMPUTE: {
+        uint16_t bs;
+        Step comp_time;
+        uint32_t output_bytes;
+        size_t n;
+        std::map< uint16_t, Step > comp_time_map;
+        std::map< uint16_t, uint32_t > output_bytes_map;
+        good = static_cast<bool>( in >> bs >> comp_time >> output_bytes >> n );
+        for ( size_t k = 0; good && k < n; k ++ ) {
+          uint16_t map_bs;
+          good = static_cast<bool>( in >> map_bs >> comp_time_map[ map_bs ] );
+        }
+        good = good && ( in >> n );
+        for ( size_t k = 0; good && k < n; k ++ ) {
+          uint16_t map_bs;
+          good = static_cast<bool>( in >> map_bs >> output_bytes_map[ map_bs ] );
+        }
+        if ( ! good )
+          break;
+        auto comp_op = new CompOp( name, OpType::COMPUTE, device, session_id, creator, comp_time_map, output_bytes_map );
+        /* restores the batch size; the time and bytes may since have been scaled */
+        comp_op->set_batch_size( bs );
+        comp_op->comp_time = comp_time;
+        comp_op->output_bytes = output_bytes;
+        op = comp_op;
+      }
+        break;
+      case OpType::MEMORY: {
+        int mem_type;
+        uint32_t num_bytes;
+        good = static_cast<bool>( in >> mem_type >> num_bytes );
+        if ( good )
+          op = new MemOp( name, OpType::MEMORY, device, session_id, MemType( mem_type ), num_bytes, creator );
+      }
+        break;
+      case OpType::NETWORK: {
+        double transfer_bytes;
+        Device *src_device;
+        Device *dst_device;
+        good = ( in >> transfer_bytes ) && load_device( in, device_of, src_device )
+            && load_device( in, device_of, dst_device );
+        if ( good )
+          op = new NetOp( name, OpType::NETWORK, device, session_id, transfer_bytes, src_device, dst_device, creator );
+      }
+        break;
+      case OpType::CONTROL_DEPENDENCY:op = new CntrlOp( name, OpType::CONTROL_DEPENDENCY, device, session_id, creator );
+        break;
+      default:good = false;
+    }
+    if ( op == nullptr )
+      break;
+    op->priority = priority;
+    ops.push_back( op );
+    adj[ op ];
+    reverse_adj[ op ];
+  }
+  size_t num_edges = 0;
+  good = good && ( in >> tag >> num_edges ) && tag == "edges";
+  for ( size_t i = 0; good && i < num_edges; i ++ ) {
+    size_t u, v;
+    good = ( in >> u >> v ) && u < ops.size( ) && v < ops.size( );
+    if ( good )
+      add_edge( ops[ u ], ops[ v ] );
+  }
+  if ( ! good || ops.size( ) != num_ops ) {
+    release_ops( ).ok( );
+    adj.clear( );
+    reverse_adj.clear( );
+    return ExitStatus::FAILURE;
+  }
+  return ExitStatus::SUCCESS;
+}
+
 ExitStatus CG::priority_sort( std::map< uint32_t, Op * > &prior_sorted ) {
   for ( auto e : adj ) {
     prior_sorted[ e.first->priority ] = e.first;
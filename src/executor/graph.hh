@@ -5,18 +5,20 @@
 #include <list>
 #include <stack>
 #include <algorithm>
+#include <functional>
 #include "exit_status.hh"
 #include "op.hh"
 #include "graph_profile.pb.h"
 
-template< class NodeType >
+/* nodes are visited in Compare order */
+template< class NodeType, class Compare = std::less< NodeType > >
 class Graph {
  private:
-  std::map< NodeType, bool > visited;
+  std::map< NodeType, bool, Compare > visited;
  public:
-  std::map< NodeType, std::set< NodeType > > adj;
+  std::map< NodeType, std::set< NodeType, Compare >, Compare > adj;
   /* a map to predecessors ( memory redundancy :D )*/
-  std::map< NodeType, std::set< NodeType > > reverse_adj;
+  std::map< NodeType, std::set< NodeType, Compare >, Compare > reverse_adj;
 
   std::vector< NodeType > sorted;
  private:
@@ -38,8 +40,8 @@ class Graph {
   ExitStatus descendants_map( std::unordered_map< NodeType, std::unordered_set< NodeType>> &descendants );
 };
 
-template< class NodeType >
-ExitStatus Graph< NodeType >::add_edge( NodeType u, NodeType v ) {
+template< class NodeType, class Compare >
+ExitStatus Graph< NodeType, Compare >::add_edge( NodeType u, NodeType v ) {
   adj[ v ]; /* create dst node if it already doesn't exist */
   adj[ u ].emplace( v );
 
@@ -50,8 +52,8 @@ ExitStatus Graph< NodeType >::add_edge( NodeType u, NodeType v ) {
   return ExitStatus::SUCCESS;
 }
 
-template< class NodeType >
-ExitStatus Graph< NodeType >::dfs( NodeType u, std::stack< NodeType > &stack ) {
+template< class NodeType, class Compare >
+ExitStatus Graph< NodeType, Compare >::dfs( NodeType u, std::stack< NodeType > &stack ) {
   visited.at( u ) = true;
   for ( auto v : adj[ u ] ) {
     if ( ! visited.at( v ))
@@ -61,8 +63,8 @@ ExitStatus Graph< NodeType >::dfs( NodeType u, std::stack< NodeType > &stack ) {
   return ExitStatus::SUCCESS;
 }
 
-template< class NodeType >
-ExitStatus Graph< NodeType >::topological_sort( std::stack< NodeType > &stack ) {
+template< class NodeType, class Compare >
+ExitStatus Graph< NodeType, Compare >::topological_sort( std::stack< NodeType > &stack ) {
   visited.clear( );
   for ( auto i : adj )
     visited.emplace( i.first, false );
@@ -72,8 +74,8 @@ ExitStatus Graph< NodeType >::topological_sort( std::stack< NodeType > &stack )
   return ExitStatus::SUCCESS;
 }
 
-template< class NodeType >
-ExitStatus Graph< NodeType >::find_descendants( NodeType u,
+template< class NodeType, class Compare >
+ExitStatus Graph< NodeType, Compare >::find_descendants( NodeType u,
                                                 std::unordered_map< NodeType,
                                                                     std::unordered_set< NodeType > > &descendants ) {
   if ( descendants.count( u ) == 0 ) {
@@ -87,8 +89,8 @@ ExitStatus Graph< NodeType >::find_descendants( NodeType u,
   return ExitStatus::SUCCESS;
 }
 
-template< class NodeType >
-ExitStatus Graph< NodeType >::descendants_map( std::unordered_map< NodeType,
+template< class NodeType, class Compare >
+ExitStatus Graph< NodeType, Compare >::descendants_map( std::unordered_map< NodeType,
                                                                    std::unordered_set< NodeType > > &descendants ) {
   for ( auto e : adj ) {
     if ( descendants.count( e.first ) == 0 )
@@ -97,8 +99,8 @@ ExitStatus Graph< NodeType >::descendants_map( std::unordered_map< NodeType,
   return ExitStatus::SUCCESS;
 }
 
-template< class NodeType >
-ExitStatus Graph< NodeType >::summary( ) const {
+template< class NodeType, class Compare >
+ExitStatus Graph< NodeType, Compare >::summary( ) const {
   for ( auto n : adj ) {
     std::cout << n.first << ": ";
     for ( auto s : n.second ) {
@@ -109,7 +111,9 @@ ExitStatus Graph< NodeType >::summary( ) const {
   return ExitStatus::SUCCESS;
 }
 
-class CG : public Graph< Op * > {
+/* ops go in creation order, so that a graph is walked the same way
+ * whichever thread allocated its ops */
+class CG : public Graph< Op *, OpSeqLess > {
  public:
   ExitStatus summary( ) const override;
 
@@ -119,6 +123,23 @@ class CG : public Graph< Op * > {
 
   ExitStatus scale_graph( CG &scaled_graph, const double &batch_factor ) const;
 
+  /* deep copy: every op is copied, so the copy can be re-batched and
+   * placed without touching this graph's ops */
+  ExitStatus clone( CG &copy ) const;
+
+  /* moves every op, and the ends of every network op, from its device d
+   * to device_of( d ), e.g. onto another simulation's gpus */
+  ExitStatus remap_devices( const std::function< Device *( Device * ) > &device_of );
+
+  /* writes the ops, in creation order, and the edges as text; a device is
+   * written as its type and dev_id */
+  ExitStatus save( std::ostream &out ) const;
+
+  /* reads back a graph written by save( ) into this empty graph, getting
+   * the devices from device_of( type, dev_id ); FAILURE if the input is
+   * malformed or names a device device_of( ) doesn't know */
+  ExitStatus load( std::istream &in, const std::function< Device *( DeviceType, DeviceId ) > &device_of );
+
   ExitStatus priority_sort( std::map< uint32_t, Op * > &prior_sorted );
 
   ExitStatus critical_path_len( int &max_depth );
@@ -1,5 +1,7 @@
 #include "op.hh"
 
+std::atomic< uint64_t > Op::next_seq( 0 );
+
 void CompOp::copy_scale_to( CompOp *new_op, double batch_scale ) const {
 //  new_op->name = name;
 //  new_op->type = type;
@@ -1,5 +1,7 @@
 #ifndef TEST_OP_H
 #define TEST_OP_H
+#include <atomic>
+#include <functional>
 #include <limits>
 #include <set>
 #include <unordered_map>
@@ -35,6 +37,11 @@ class Op {
   uint16_t session_id;
   const std::string creator;
   uint32_t priority;
+  /* creation order; a copy is created after its original, so it gets
+   * its own and copies of a graph made in order keep the same order */
+  const uint64_t seq;
+ private:
+  static std::atomic< uint64_t > next_seq;
  public:
   Op( std::string name,
       OpType type,
@@ -49,13 +56,23 @@ class Op {
         status( OpStatus::WAITING ),
         session_id( sessionId ),
         creator( std::move( creator ) ),
-        priority( 0 ) { }
+        priority( 0 ),
+        seq( next_seq ++ ) { }
 
 //  ExitStatus duplicate( uint32_t n_copies, std::vector< Op* > &new_ops );
   virtual ~Op( ) = default;
 
 
-  Op( const Op & ) = default;
+  Op( const Op &other ) : name( other.name ),
+                         type( other.type ),
+                         device( other.device ),
+                         start( other.start ),
+                         end( other.end ),
+                         status( other.status ),
+                         session_id( other.session_id ),
+                         creator( other.creator ),
+                         priority( other.priority ),
+                         seq( next_seq ++ ) { }
 
   Op &operator=( const Op & ) = delete;
 
@@ -166,4 +183,22 @@ class MemOp : public Op {
   ExitStatus get_mem_size( uint64_t &size ) const override;
 };
 
+/* orders ops by creation rather than by address, for the containers whose
+ * iteration order decides which op is placed, partitioned or launched
+ * first; these then don't depend on where the allocator put the ops, so
+ * the same graph built on different threads, e.g. in concurrent strategy
+ * candidates, is processed the same way. Creation order is the canonical
+ * order of a graph's ops. Address order only repeated for one allocator and
+ * thread layout, and moving off it changes which of two ready ops goes
+ * first, so simulated times may differ from runs made in address order */
+struct OpSeqLess {
+  bool operator()( const Op *a, const Op *b ) const {
+    return a->seq < b->seq;
+  }
+};
+
+/* a map from ops in OpSeqLess order */
+template< class T >
+using OpMap = std::map< Op *, T, OpSeqLess >;
+
 #endif //TEST_OP_H
@@ -19,15 +19,15 @@ ExitStatus Session::launch_op( Op *op ) {
 ExitStatus Session::launch_op( CompOp *op ) {
   assert( op->status == OpStatus::READY );
   if ( op->device->type == DeviceType::CPU ) {
-    op->start = Device::curr_step;
+    op->start = curr_step;
     /* assume there are enough cpu cores available to
      * schedule each cpu op without significant waiting */
-    op->end = Device::curr_step + op->comp_time;
+    op->end = curr_step + op->comp_time;
     op->status = OpStatus::WORKING;
   } else if ( op->device->type == DeviceType::GPU ) {
-    gpus[ op->device->dev_id ].compute( op );
-    op->status = ( op->start == Device::curr_step ? OpStatus::WORKING : OpStatus::SCHEDULED );
-    op->status = ( op->end == Device::curr_step ? OpStatus::FINISHED : op->status );
+    gpus[ op->device->dev_id ].compute( op, curr_step );
+    op->status = ( op->start == curr_step ? OpStatus::WORKING : OpStatus::SCHEDULED );
+    op->status = ( op->end == curr_step ? OpStatus::FINISHED : op->status );
   } else return ExitStatus::FAILURE;
   return ExitStatus::SUCCESS;
 }
@@ -38,7 +38,7 @@ ExitStatus Session::launch_op( NetOp *op ) {
   if ( op->device->type == DeviceType::INTERCONNECT ) {
     assert( op->src_device->type == DeviceType::GPU );
     assert( op->dst_device->type == DeviceType::GPU );
-    gpus[ op->src_device->dev_id ].communicate( op );
+    gpus[ op->src_device->dev_id ].communicate( op, curr_step );
     /* the receiver GPU will set a recv signal when
      * the communication is finished and the op status
      * changes automatically */
@@ -53,8 +53,8 @@ ExitStatus Session::launch_op( NetOp *op ) {
 ExitStatus Session::launch_op( CntrlOp *op ) {
   assert( op->session_id == id );
   assert( op->status == OpStatus::READY );
-  op->start = Device::curr_step;
-  op->end = Device::curr_step;
+  op->start = curr_step;
+  op->end = curr_step;
   op->status = OpStatus::FINISHED;
   return ExitStatus::SUCCESS;
 }
@@ -62,8 +62,8 @@ ExitStatus Session::launch_op( CntrlOp *op ) {
 ExitStatus Session::launch_op( MemOp *op ) {
   assert( op->session_id == id );
   assert( op->status == OpStatus::READY );
-  op->start = Device::curr_step;
-  op->end = Device::curr_step;
+  op->start = curr_step;
+  op->end = curr_step;
   op->status = OpStatus::FINISHED;
   return ExitStatus::SUCCESS;
 }
@@ -77,7 +77,7 @@ ExitStatus Session::update_focus_closure( ) {
   for ( auto op : focus_closure ) {
     /* make sure all finished ops are in
      * correct status */
-    if ( op->end <= Device::curr_step ) {
+    if ( op->end <= curr_step ) {
       op->status = OpStatus::FINISHED;
     }
     /* expand the closure by adding successors
@@ -141,19 +141,19 @@ ExitStatus Session::proceed( bool &done ) {
 
   /* when an iteration is finished */
   if ( focus_closure.empty( )) {
-    std::cout << "Finished a pass at step=" << Device::curr_step
+    std::cout << "Finished a pass at step=" << curr_step
               << std::endl;
     has_finished_pass = true;
     done = true;
     log( );
   }
-  if ( Device::curr_step % 1000 == 0 )
+  if ( curr_step % 1000 == 0 )
     progress_log( ).ok( );
   return ExitStatus::SUCCESS;
 }
 
 ExitStatus Session::log( ) {
-  log_file << Device::curr_step << std::endl;
+  log_file << curr_step << std::endl;
   log_file.close( );
   return ExitStatus::SUCCESS;
 }
@@ -165,7 +165,7 @@ ExitStatus Session::progress_log( ) {
       num_finished_ops ++;
   }
   std::cout << "[ session ]" << " "
-            << "curr_step=" << Device::curr_step << " "
+            << "curr_step=" << curr_step << " "
             << "num_finished_ops=" << num_finished_ops << " "
             << "total_ops=" << graph.adj.size( ) << " "
             << std::endl;
@@ -17,17 +17,20 @@ class Session {
   const std::string log_dir;
  public:
   bool has_finished_pass;
+  /* the session's own clock; the driver advances it after each proceed( ) */
+  Step curr_step;
  private:
   /* maintain a set of ops that are likely to
-   * change op_status at each step */
-  std::set< Op * > focus_closure;
+   * change op_status at each step; ops launch in this order, so it goes
+   * by creation for a clone of a graph to simulate like the graph */
+  std::set< Op *, OpSeqLess > focus_closure;
   std::ofstream log_file;
  public:
   Session( uint16_t id,
            GPU *gpus,
            CG &graph,
            const std::string log_dir )
-      : id( id ), gpus( gpus ), graph( graph ), log_dir( log_dir ), has_finished_pass( true ), focus_closure( ), log_file( ) {
+      : id( id ), gpus( gpus ), graph( graph ), log_dir( log_dir ), has_finished_pass( true ), curr_step( 0 ), focus_closure( ), log_file( ) {
     restart( ).ok( ); /* initialize the graph */
     log_file = std::ofstream( log_dir + "session.log", std::ofstream::out );
   }
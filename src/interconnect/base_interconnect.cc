@@ -1,111 +1,319 @@
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include "base_interconnect.hh"
-#define MAX_NUM_GPUS 4096
 
-ExitStatus BaseInterconnect::proceed_ingress( ) {
-  bool ingress_rate_cond;
-  uint64_t ingress_bytes_budget[MAX_NUM_GPUS];
-  uint64_t max_step_bytes = ingress_link_speed * cnfg.step_size_sec; //ToDo: double check
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
-    ingress_bytes_budget[i] = max_step_bytes;
+ExitStatus BaseInterconnect::ingest( DeviceId i, Packet *pkt ) {
+  assert( pkt->src->dev_id == i );
+  assert( pkt->dst->dev_id != i );
+  auto &queue = to_send_buff[ pkt->src->dev_id ][ pkt->dst->dev_id ];
+  queue.pkts.push_back( pkt );
+  queue.num_bytes += pkt->num_bytes;
+  /* every packet ingested for gpu i has i as its source, so a single
+   * running budget per gpu is enough */
+  ingress_bytes_budget[ i ] -= pkt->num_bytes;
+  ingress_rate_cond[ i ] = ( ingress_bytes_budget[ i ] >= pkt->num_bytes );
+  return ExitStatus::SUCCESS;
+}
+
+uint64_t BaseInterconnect::ingress_step_bytes( ) const {
+  return ingress_link_speed * cnfg.step_size_sec; //ToDo: double check
+}
+
+ExitStatus BaseInterconnect::offline_port_bw_est( double &tx_bw, double &rx_bw ) const {
+  tx_bw = ingress_link_speed * cnfg.step_size_sec;
+  rx_bw = egress_link_speed * cnfg.step_size_sec;
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::ingress_backlog_row( DeviceId i ) {
+  Packet *pkt;
+  ingress_bytes_budget[ i ] = ingress_step_bytes( );
+  ingress_rate_cond[ i ] = true;
+  while ( ingress_rate_cond[ i ] && ! tx_backlog[ i ].empty( )) {
+    pkt = tx_backlog[ i ].front( );
+    tx_backlog[ i ].pop_front( );
+    ingest( i, pkt ).ok( );
   }
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::ingress_sent_row( DeviceId i ) {
   Packet *pkt;
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
-    ingress_rate_cond = true;
-    while ( ingress_rate_cond ) {
-      if ( gpus[ i ].fetch_tx( pkt ) == ExitStatus::SUCCESS ) {
-        assert( pkt->tx_time == curr_step );
-        assert( pkt->src->dev_id == i );
-        assert( pkt->dst->dev_id != i );
-        to_send_buff[ pkt->src->dev_id ][ pkt->dst->dev_id ].push_back( pkt );
-        ingress_bytes_budget[ pkt->src->dev_id ] -= pkt->num_bytes;
-        ingress_rate_cond = ( ingress_bytes_budget[ pkt->src->dev_id ] >= pkt->num_bytes );
-      } else break;
-    }
+  while ( ingress_rate_cond[ i ] ) {
+    if ( gpus[ i ].fetch_tx( pkt ) == ExitStatus::SUCCESS ) {
+      assert( pkt->tx_time == curr_step );
+      ingest( i, pkt ).ok( );
+    } else break;
   }
+  /* what the budget didn't allow waits for the next step */
+  gpus[ i ].fetch_tx( tx_backlog[ i ] ).ok( );
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus BaseInterconnect::proceed_egress( ) {
-  bool egress_rate_cond;
-  uint64_t egress_bytes_budget[MAX_NUM_GPUS];
-  uint64_t max_step_bytes = egress_link_speed * cnfg.step_size_sec; //ToDo: double check
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
-    egress_bytes_budget[i] = max_step_bytes;
+ExitStatus BaseInterconnect::ingress_window_row( DeviceId i, Step now ) {
+  Packet *pkt;
+  /* the budget is only left when the backlog from before the window ran out
+   * in this step; the packets held back earlier in the window come next,
+   * then the ones sent in this step, as in ingress_sent_row( ) */
+  while ( ingress_rate_cond[ i ] && ! window_backlog[ i ].empty( )) {
+    pkt = window_backlog[ i ].front( );
+    window_backlog[ i ].pop_front( );
+    ingest( i, pkt ).ok( );
   }
+  while ( ingress_rate_cond[ i ] ) {
+    if ( gpus[ i ].fetch_tx( pkt, now ) == ExitStatus::SUCCESS ) {
+      assert( pkt->tx_time == now );
+      ingest( i, pkt ).ok( );
+    } else break;
+  }
+  gpus[ i ].fetch_tx( window_backlog[ i ], now ).ok( );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::proceed_ingress_backlog( ) {
+  return for_each_partition( [ this ]( size_t, DeviceId first, DeviceId last ) {
+    for ( DeviceId i = first; i < last; i ++ )
+      ingress_backlog_row( i ).ok( );
+  } );
+}
+
+ExitStatus BaseInterconnect::proceed_ingress_sent( ) {
+  return for_each_partition( [ this ]( size_t, DeviceId first, DeviceId last ) {
+    for ( DeviceId i = first; i < last; i ++ )
+      ingress_sent_row( i ).ok( );
+  } );
+}
+
+ExitStatus BaseInterconnect::proceed_ingress( ) {
+  proceed_ingress_backlog( ).ok( );
+  proceed_ingress_sent( ).ok( );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::egress_rows( DeviceId first, DeviceId last, Step now, PacketQueue &out ) {
+  const uint64_t max_step_bytes = egress_link_speed * cnfg.step_size_sec; //ToDo: double check
+  bool egress_rate_cond;
+  /* as in ingress, packets queued for gpu i all have i as their destination */
+  uint64_t egress_bytes_budget;
   Packet *pkt;
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
+  for ( DeviceId i = first; i < last; i ++ ) {
+    egress_bytes_budget = max_step_bytes;
     egress_rate_cond = true;
     while ( ( ! to_recv_buff[ i ].empty( ) ) && egress_rate_cond ) {
       pkt = to_recv_buff[ i ].front( );
-      assert( pkt->rx_time == curr_step );
-      egress_bytes_budget[ pkt->dst->dev_id ] -= pkt->num_bytes;
-      egress_rate_cond = ( egress_bytes_budget[ pkt->dst->dev_id ] >= pkt->num_bytes );
+      assert( pkt->dst->dev_id == i );
+      egress_bytes_budget -= pkt->num_bytes;
+      egress_rate_cond = ( egress_bytes_budget >= pkt->num_bytes );
       to_recv_buff[ i ].pop_front( );
-      gpus[ i ].fill_rx( pkt, 1 ).ok( ); //fill_rx removes the packet from the memory; so call it the at the end.
+      pkt->egress_time = now;
+      out.push_back( pkt );
     }
   }
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus BaseInterconnect::reset_routing_step_counters( ){
+ExitStatus BaseInterconnect::proceed_egress( ) {
+  for_each_partition( [ this ]( size_t part, DeviceId first, DeviceId last ) {
+    egress_rows( first, last, curr_step, egressed[ part ] ).ok( );
+  } ).ok( );
+  /* receiving touches the senders' transports, so it stays on this thread,
+   * in gpu order */
+  for ( auto &pkts : egressed ) {
+    if ( defer_delivery )
+      delivered.splice_back( pkts );
+    else
+      deliver( pkts ).ok( );
+  }
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus BaseInterconnect::proceed_routing( ) {
-  reset_routing_step_counters( ).ok( ); // can be used for rate limiting, etc.
-  bool is_feasible;
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
-    for ( uint16_t j = 0; j < num_gpus; j ++ ) {
-      while ( ! to_send_buff[ i ][ j ].empty( )) {
-        Packet *cand_pkt = to_send_buff[ i ][ j ].front( );
-        assert( cand_pkt->src->dev_id == i );
-        assert( cand_pkt->dst->dev_id == j );
-        is_routing_feasible( cand_pkt, is_feasible );
-        bool is_lat_met = ( cand_pkt->tx_time + cnfg.interconnect_latency ) <= Device::curr_step;
-        if ( is_feasible && is_lat_met ) {
-//          step_bytes_budget.sub_elem_by( i, j, cand_pkt->num_bytes );
-          total_bytes_transferred += cand_pkt->num_bytes;
-          cand_pkt->rx_time = curr_step;
-          to_recv_buff[ j ].push_back( cand_pkt );
+/* move the packets at the front of from whose time is at most step */
+static void splice_until( PacketQueue &to, PacketQueue &from, Step Packet::*time, Step step ) {
+  size_t num_pkts = 0;
+  for ( const Packet *pkt : from ) {
+    if ( pkt->*time > step )
+      break;
+    num_pkts ++;
+  }
+  to.splice_back( from, num_pkts );
+}
+
+Step BaseInterconnect::window_size( Step max_len ) const {
+  if ( is_episode_start( ))
+    return 0;
+  const Step episode_len = cnfg.dec_interval + cnfg.interconnect_reconf_delay;
+  Step len = std::min( max_len, cnfg.interconnect_latency );
+  len = std::min( len, episode_len - curr_step % episode_len );
+  /* end on progress log steps, so that the logs come out in the same order
+   * as when stepping one at a time */
+  return std::min( len, Step( ( progress_log_interval - curr_step % progress_log_interval ) % progress_log_interval + 1 ));
+}
 
-          to_send_buff[ i ][ j ].pop_front( );
-        } else {
-          break;
-        }
+ExitStatus BaseInterconnect::proceed_window_ahead( Step len ) {
+  assert( len > 0 && len <= window_size( len ));
+  assert( defer_delivery );
+  window_ingress_budget.resize( size_t( len ) * num_gpus );
+  window_ingress_cond.resize( size_t( len ) * num_gpus );
+  /* the packets sent before the window are at the front of every backlog,
+   * and only they can be routed within it: each partition ingests and
+   * routes its sources through the whole window on its own */
+  for_each_partition( [ this, len ]( size_t part, DeviceId first, DeviceId last ) {
+    for ( Step s = 0; s < len; s ++ ) {
+      for ( DeviceId i = first; i < last; i ++ ) {
+        ingress_backlog_row( i ).ok( );
+        window_ingress_budget[ size_t( s ) * num_gpus + i ] = ingress_bytes_budget[ i ];
+        window_ingress_cond[ size_t( s ) * num_gpus + i ] = ingress_rate_cond[ i ];
+      }
+      route_window_rows( part, first, last, curr_step + s ).ok( );
+    }
+  } ).ok( );
+  for ( auto &bytes : routed_bytes ) {
+    total_bytes_transferred += bytes;
+    bytes = 0;
+  }
+  /* then each partition egresses its destinations through the window,
+   * taking the packets routed in each step in partition ( source ) order */
+  for_each_partition( [ this, len ]( size_t part, DeviceId first, DeviceId last ) {
+    for ( Step s = 0; s < len; s ++ ) {
+      for ( DeviceId j = first; j < last; j ++ ) {
+        for ( auto &dst_queues : routed )
+          splice_until( to_recv_buff[ j ], dst_queues[ j ], &Packet::rx_time, curr_step + s );
       }
+      egress_rows( first, last, curr_step + s, egressed[ part ] ).ok( );
     }
+  } ).ok( );
+  for ( Step s = 0; s < len; s ++ ) {
+    for ( auto &pkts : egressed )
+      splice_until( delivered, pkts, &Packet::egress_time, curr_step + s );
   }
   return ExitStatus::SUCCESS;
 }
 
+ExitStatus BaseInterconnect::proceed_window_behind( Step len ) {
+  for_each_partition( [ this, len ]( size_t, DeviceId first, DeviceId last ) {
+    for ( Step s = 0; s < len; s ++ ) {
+      for ( DeviceId i = first; i < last; i ++ ) {
+        ingress_bytes_budget[ i ] = window_ingress_budget[ size_t( s ) * num_gpus + i ];
+        ingress_rate_cond[ i ] = window_ingress_cond[ size_t( s ) * num_gpus + i ];
+        ingress_window_row( i, curr_step + s ).ok( );
+      }
+    }
+    for ( DeviceId i = first; i < last; i ++ )
+      tx_backlog[ i ].splice_back( window_backlog[ i ] );
+  } ).ok( );
+  /* the window ends on a log step, if it has one */
+  curr_step += len - 1;
+  proceed_log( ).ok( );
+  curr_step ++;
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::for_each_partition( const std::function< void( size_t, DeviceId, DeviceId ) > &part ) {
+  if ( pool == nullptr ) {
+    part( 0, 0, num_gpus );
+    return ExitStatus::SUCCESS;
+  }
+  const size_t num_parts = pool->size( );
+  pool->run( [ this, &part, num_parts ]( size_t p ) {
+    part( p, DeviceId( uint64_t( num_gpus ) * p / num_parts ), DeviceId( uint64_t( num_gpus ) * ( p + 1 ) / num_parts ));
+  } );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::set_num_threads( size_t num_threads ) {
+  delete pool;
+  pool = ( num_threads > 1 ? new WorkerPool( num_threads ) : nullptr );
+  const size_t num_parts = num_partitions( );
+  routed.clear( );
+  routed.resize( num_parts );
+  for ( auto &dsts : routed )
+    dsts.resize( num_gpus );
+  routed_dsts.assign( num_parts, { } );
+  routed_bytes.assign( num_parts, 0 );
+  egressed.clear( );
+  egressed.resize( num_parts );
+  return ExitStatus::SUCCESS;
+}
+
+BaseInterconnect::~BaseInterconnect( ) {
+  delete pool;
+}
+
 ExitStatus BaseInterconnect::allocate_step_bw( ) {
 //  step_bytes_budget.copy_from( episode_bw );
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus BaseInterconnect::proceed( ) {
-  if ( curr_step % ( cnfg.dec_interval + cnfg.interconnect_reconf_delay )== 0 ) {
+bool BaseInterconnect::is_episode_start( ) const {
+  return ( curr_step % ( cnfg.dec_interval + cnfg.interconnect_reconf_delay ) == 0 );
+}
+
+ExitStatus BaseInterconnect::proceed_episode( ) {
+  if ( is_episode_start( )) {
     tm_estimator->update_tm_est( ).ok( );
     allocate_episode_bw( ).ok( );
   }
+  return ExitStatus::SUCCESS;
+}
 
-//  allocate_step_bw( ).ok( );
-  proceed_ingress( ).ok( );
+ExitStatus BaseInterconnect::proceed_transfer( ) {
   proceed_routing( ).ok( );
   proceed_egress( ).ok( );
-  if ( Device::curr_step % 1000 == 0 )
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::proceed_log( ) {
+  if ( curr_step % progress_log_interval == 0 )
     progress_log( ).ok( );
   return ExitStatus::SUCCESS;
 }
 
+ExitStatus BaseInterconnect::proceed( ) {
+  proceed_episode( ).ok( );
+//  allocate_step_bw( ).ok( );
+  proceed_ingress( ).ok( );
+  proceed_transfer( ).ok( );
+  proceed_log( ).ok( );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::set_deferred_delivery( bool defer ) {
+  defer_delivery = defer;
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::collect_delivered( PacketQueue &pkts ) {
+  pkts.splice_back( delivered );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::deliver( PacketQueue &pkts, Step before ) {
+  Packet *pkt;
+  while ( ! pkts.empty( ) && pkts.front( )->egress_time < before ) {
+    pkt = pkts.front( );
+    pkts.pop_front( );
+    gpus[ pkt->dst->dev_id ].fill_rx( pkt, 1 ).ok( );
+  }
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus BaseInterconnect::deliver( PacketQueue &pkts ) {
+  Packet *pkt;
+  while ( ! pkts.empty( )) {
+    pkt = pkts.front( );
+    pkts.pop_front( );
+    gpus[ pkt->dst->dev_id ].fill_rx( pkt, 1 ).ok( );
+  }
+  return ExitStatus::SUCCESS;
+}
+
 ExitStatus BaseInterconnect::report_episode_bw( ) {
   std::cout << episode_bw;
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus BaseInterconnect::normalize_tm( Matrix2D< double > &normal_tm ) const {
+ExitStatus BaseInterconnect::normalize_tm( SparseMatrix2D< double > &normal_tm ) const {
   normal_tm.copy_from( tm_estimator->tm_est );
   normal_tm.normalize_by_max( );
   return ExitStatus::SUCCESS;
@@ -113,7 +321,7 @@ ExitStatus BaseInterconnect::normalize_tm( Matrix2D< double > &normal_tm ) const
 
 ExitStatus BaseInterconnect::progress_log( ) {
   std::cout << "[ interconnect ]" << " "
-            << "curr_step=" << Device::curr_step << " "
+            << "curr_step=" << curr_step << " "
             << "total_bytes_transferred=" << total_bytes_transferred << " "
             << std::endl;
   return ExitStatus::SUCCESS;
@@ -1,41 +1,84 @@
 #ifndef TEST_INTERCONNECT_H
 #define TEST_INTERCONNECT_H
-#include <deque>
+#include <map>
+#include <vector>
 #include <assert.h>
-#include "packet.hh"
+#include "packet_queue.hh"
+#include "worker_pool.hh"
 #include "gpu.hh"
 #include "tm_estimator.hh"
+#include "pair_budget.hh"
 #include "config.h"
 
 #ifdef HAVE_GUROBI
 #include "gurobi_c++.h"
 #endif //HAVE_GUROBI
 
+/* packets waiting at the interconnect for one (src, dst) pair, in tx_time order */
+struct PairQueue {
+  PacketQueue pkts;
+  uint64_t num_bytes; /* total bytes of pkts */
+  /* the pair's id in a budgeted interconnect's PairBudget; only a cache of
+   * it, so admit( ) may refresh it through a const queue */
+  mutable PairBudgetId budget_id;
+
+  PairQueue( ) : pkts( ), num_bytes( 0 ), budget_id( ) { }
+};
+
 class BaseInterconnect : public Device {
  public:
   GPU *gpus;
  public:
-  uint16_t num_gpus;
+  DeviceId num_gpus;
+ protected:
+  /* per-source queues keyed by destination; a queue is only created once
+   * its pair carries traffic, so memory grows with the active pairs rather
+   * than num_gpus x num_gpus */
+  std::vector< std::map< DeviceId, PairQueue > > to_send_buff;
+  std::vector< PacketQueue > to_recv_buff;
  private:
-  std::deque< Packet * > **to_send_buff;
-  std::deque< Packet * > *to_recv_buff;
+  /* per-gpu packets that didn't fit in an earlier step's ingress budget */
+  std::vector< PacketQueue > tx_backlog;
+  /* in windowed stepping, the part of tx_backlog sent within the current
+   * window, and each window step's ingress budget ( step-major, then gpu )
+   * left after the packets sent before the window */
+  std::vector< PacketQueue > window_backlog;
+  std::vector< uint64_t > window_ingress_budget;
+  std::vector< uint8_t > window_ingress_cond;
+  std::vector< uint64_t > ingress_bytes_budget;
+  std::vector< uint8_t > ingress_rate_cond; /* not vector< bool >: gpus are updated from several threads */
 //  Matrix2D< double > step_bytes_budget;
   const double ingress_link_speed;
   const double egress_link_speed;
  protected:
-  Matrix2D< double > episode_bw;
-  std::map< uint16_t, std::map< uint16_t, double > > sparse_episode_bw;
+  /* bandwidth (bytes per step) allocated to each gpu pair for the current
+   * episode; only the pairs with a non-zero allocation are stored */
+  SparseMatrix2D< double > episode_bw;
  public:
   TMEstimatorBase *tm_estimator;
   SimConfig cnfg;
- private:
-  uint64_t total_bytes_transferred;
+  /* the interconnect's own clock; the driver advances it after each step */
+  Step curr_step;
  protected:
+  uint64_t total_bytes_transferred;
   const std::string log_dir;
+  static constexpr Step progress_log_interval = 1000;
+ private:
+  bool defer_delivery;
+  PacketQueue delivered;
+ protected:
+  /* with more than one thread, every phase of a step splits the gpus into
+   * pool->size( ) contiguous partitions, one per thread; see set_num_threads */
+  WorkerPool *pool;
+  std::vector< std::vector< PacketQueue > > routed;   /* partition -> dst -> packets routed this step */
+  std::vector< std::vector< DeviceId > > routed_dsts; /* partition -> dsts with packets in routed */
+  std::vector< uint64_t > routed_bytes;               /* partition -> bytes routed this step */
+ private:
+  std::vector< PacketQueue > egressed;                /* partition -> packets leaving this step */
  public:
-  BaseInterconnect( uint16_t dev_id,
+  BaseInterconnect( DeviceId dev_id,
                     GPU *gpus,
-                    uint16_t num_gpus,
+                    DeviceId num_gpus,
                     double ingress_link_speed,
                     double egress_link_speed,
                     TMEstimatorBase *tm_estimator,
@@ -43,25 +86,89 @@ class BaseInterconnect : public Device {
                     const std::string log_dir ) : Device( dev_id, DeviceType::INTERCONNECT ),
                                                   gpus( gpus ),
                                                   num_gpus( num_gpus ),
-                                                  to_send_buff( ),
-                                                  to_recv_buff( ),
+                                                  to_send_buff( num_gpus ),
+                                                  to_recv_buff( num_gpus ),
+                                                  tx_backlog( num_gpus ),
+                                                  window_backlog( num_gpus ),
+                                                  window_ingress_budget( ),
+                                                  window_ingress_cond( ),
+                                                  ingress_bytes_budget( num_gpus ),
+                                                  ingress_rate_cond( num_gpus ),
 //                                                  step_bytes_budget( num_gpus, num_gpus ),
                                                   ingress_link_speed( ingress_link_speed ),
                                                   egress_link_speed( egress_link_speed ),
                                                   episode_bw( num_gpus, num_gpus ),
                                                   tm_estimator( tm_estimator ),
                                                   cnfg( cnfg ),
+                                                  curr_step( 0 ),
                                                   total_bytes_transferred( 0 ),
-                                                  log_dir( log_dir ) {
-    to_recv_buff = new std::deque< Packet * >[num_gpus];
-    to_send_buff = new std::deque< Packet * > *[num_gpus];
-    for ( int gpu_no = 0; gpu_no < num_gpus; gpu_no ++ ) {
-      to_send_buff[ gpu_no ] = new std::deque< Packet * >[num_gpus];
-    }
+                                                  log_dir( log_dir ),
+                                                  defer_delivery( false ),
+                                                  delivered( ),
+                                                  pool( nullptr ),
+                                                  routed( ),
+                                                  routed_dsts( ),
+                                                  routed_bytes( ),
+                                                  egressed( ) {
+    set_num_threads( 1 ).ok( );
   }
 
   ExitStatus proceed( );
 
+  /* the phases of proceed( ), in order, for drivers that overlap some of
+   * them with the sessions; see run_simulation( ) */
+  bool is_episode_start( ) const;
+
+  ExitStatus proceed_episode( );
+
+  ExitStatus proceed_ingress( );
+
+  /* proceed_ingress( ) in two parts: first the packets held back in earlier
+   * steps, which don't depend on this step's sessions, then the ones the
+   * sessions sent in this step */
+  ExitStatus proceed_ingress_backlog( );
+
+  ExitStatus proceed_ingress_sent( );
+
+  ExitStatus proceed_transfer( );
+
+  ExitStatus proceed_log( );
+
+  /* with deferred delivery, egress keeps the packets it would have handed to
+   * the receiving gpus; the driver collects them and delivers them later
+   * from the thread that runs the sessions */
+  ExitStatus set_deferred_delivery( bool defer );
+
+  ExitStatus collect_delivered( PacketQueue &pkts );
+
+  ExitStatus deliver( PacketQueue &pkts );
+
+  /* deliver the packets at the front of pkts that left the interconnect
+   * before step before */
+  ExitStatus deliver( PacketQueue &pkts, Step before );
+
+  /* Windowed stepping, for conservative parallel simulation. A packet sent
+   * in step t can't be routed before step t + interconnect_latency, so what
+   * the interconnect delivers in a window of that many steps only depends on
+   * what was sent before the window. proceed_window_ahead( len ) therefore
+   * runs steps [curr_step, curr_step + len) up front, each partition of gpus
+   * routing its own sources with its own clock, and leaves the egressed
+   * packets for collect_delivered( ). After the sessions have run those
+   * steps, proceed_window_behind( len ) ingests what they sent, step by
+   * step, and moves curr_step past the window. The results are the same as
+   * with proceed( ) at every step. window_size( max_len ) is the longest
+   * window, up to max_len, that can start at curr_step; it is 0 at episode
+   * starts, whose allocation depends on that step's sends. */
+  Step window_size( Step max_len ) const;
+
+  ExitStatus proceed_window_ahead( Step len );
+
+  ExitStatus proceed_window_behind( Step len );
+
+  /* run each step's ingress, routing and egress on num_threads threads;
+   * the results are the same for any number of threads */
+  ExitStatus set_num_threads( size_t num_threads );
+
   ExitStatus report_episode_bw( );
 
   /* offline_bw_est( ) provides an estimate of bw for all GPU pairs,
@@ -70,7 +177,9 @@ class BaseInterconnect : public Device {
   virtual ExitStatus offline_bw_est( std::unordered_map< Device *,
                                                          std::unordered_map< Device *, double>> &estimate ) = 0;
 
-  virtual ExitStatus is_routing_feasible( Packet* pkt, bool &is_bw_avail ) = 0;
+  /* bytes per step a gpu can send into ( tx ) and receive from ( rx ) the
+   * interconnect; the port-level counterpart of offline_bw_est( ) */
+  ExitStatus offline_port_bw_est( double &tx_bw, double &rx_bw ) const;
 
   BaseInterconnect( const BaseInterconnect & ) = delete;
 
@@ -80,24 +189,49 @@ class BaseInterconnect : public Device {
 
   BaseInterconnect &operator=( BaseInterconnect && ) = delete;
 
-  virtual ~BaseInterconnect( ) = default;
+  virtual ~BaseInterconnect( );
 
  protected:
-  ExitStatus normalize_tm( Matrix2D< double > &normal_tm ) const;
+  ExitStatus normalize_tm( SparseMatrix2D< double > &normal_tm ) const;
+
+  size_t num_partitions( ) const { return ( pool == nullptr ? 1 : pool->size( )); }
+
+  /* run part( p, first, last ) for every partition p of the gpus
+   * [first, last), in parallel when there is a pool */
+  ExitStatus for_each_partition( const std::function< void( size_t, DeviceId, DeviceId ) > &part );
 
  private:
-  ExitStatus proceed_ingress( );
+  ExitStatus ingest( DeviceId i, Packet *pkt );
 
   ExitStatus proceed_egress( );
 
-  ExitStatus proceed_routing( );
+  uint64_t ingress_step_bytes( ) const;
+
+  /* start gpu i's ingress budget for a step and ingest its backlog */
+  ExitStatus ingress_backlog_row( DeviceId i );
+
+  /* ingest what gpu i sent in this step while its budget lasts */
+  ExitStatus ingress_sent_row( DeviceId i );
+
+  /* ingress_sent_row( ) for a step inside the window, after the sessions
+   * have run it */
+  ExitStatus ingress_window_row( DeviceId i, Step now );
+
+  /* egress the gpus [first, last) in step now onto out */
+  ExitStatus egress_rows( DeviceId first, DeviceId last, Step now, PacketQueue &out );
+
+  /* implemented by RoutedInterconnect, which calls the concrete
+   * interconnect's routing checks without virtual dispatch */
+  virtual ExitStatus proceed_routing( ) = 0;
+
+  /* route the sources [first, last) in step now onto routed[ part ],
+   * stamping each packet's rx_time with now */
+  virtual ExitStatus route_window_rows( size_t part, DeviceId first, DeviceId last, Step now ) = 0;
 
   ExitStatus allocate_step_bw( );
 
   virtual ExitStatus allocate_episode_bw( ) = 0;
 
-  virtual ExitStatus reset_routing_step_counters( );
-
   ExitStatus progress_log( );
 };
 
@@ -1,89 +1,41 @@
 #include "electrical_switch.hh"
 
-ExitStatus ElectricalSwitch::find_matchings( Matrix2D< double > &tm_est, Matrix2D< double > &match ) {
-  /* Parallel Iterative Matching algorithm */
-  match.fill_zeros( );
-  srand( time( NULL ));
-  std::unordered_map< int, std::vector< int > > grant;
-  std::vector< int > requests;
-  int rand_index;
-  for ( int dst = 0; dst < num_gpus; dst ++ ) {
-    requests.clear( );
-    for ( int src = 0; src < num_gpus; src ++ ) {
-      if ( tm_est.get_elem( src, dst ) > 0 ) requests.push_back( src );
-    }
-    if ( ! requests.empty( )) {
-      rand_index = rand( ) % requests.size( );
-      grant[ requests[ rand_index ]].push_back( dst );
-    }
-  }
-
-  /* accept one of the grants */
-  int num_grants;
-  for ( auto g : grant ) {
-    num_grants = g.second.size( );
-    rand_index = ( num_grants > 1 ? ( rand( ) % num_grants ) : 0 );
-    match.set_elem( g.first, g.second[ rand_index ], 1.0 );
-  }
-  return ExitStatus::SUCCESS;
-}
-
 ExitStatus ElectricalSwitch::allocate_episode_bw( ) {
   tm_estimator->update_tm_est( ).ok( );
-  Matrix2D< double > match( num_gpus, num_gpus );
-  for ( int src = 0; src < num_gpus; src ++ ) {
-    double out_traffic = 0;
-    for ( int dst = src; dst < num_gpus; dst ++ ) {
-      out_traffic += tm_estimator->tm_est.get_elem( src, dst );
-    }
-    for ( int dst = src; dst < num_gpus; dst ++ ) {
-      if ( out_traffic > 0 )
-        match.set_elem( src, dst, tm_estimator->tm_est.get_elem( src, dst ) / out_traffic );
-    }
+  const SparseMatrix2D< double > &tm_est = tm_estimator->tm_est;
+  /* share each port among its pairs in proportion to their traffic:
+   * the upper triangle ( dst > src ) by the source's outgoing traffic
+   * and the rest by the destination's incoming traffic */
+  std::vector< double > out_traffic( num_gpus, 0 );
+  std::vector< double > in_traffic( num_gpus, 0 );
+  for ( const auto &e : tm_est ) {
+    if ( e.col >= e.row )
+      out_traffic[ e.row ] += e.value;
+    if ( e.row >= e.col )
+      in_traffic[ e.col ] += e.value;
   }
-  for ( int src = 0; src < num_gpus; src ++ ) {
-    double out_traffic = 0;
-    for ( int dst = src; dst < num_gpus; dst ++ ) {
-      out_traffic += tm_estimator->tm_est.get_elem( dst, src );
-    }
-    for ( int dst = src; dst < num_gpus; dst ++ ) {
-      if ( out_traffic > 0 )
-        match.set_elem( dst, src, tm_estimator->tm_est.get_elem( dst, src ) / out_traffic );
-    }
-  }
-  for ( int dst = 0; dst < num_gpus; dst ++ ) {
-    for ( int src = 0; src < num_gpus; src ++ ) {
-      episode_bw.set_elem( src, dst, match.get_elem( src, dst ) * bwxstep_per_port );
-    }
+  episode_bw.fill_zeros( );
+  for ( const auto &e : tm_est ) {
+    double traffic = ( e.col > e.row ? out_traffic[ e.row ] : in_traffic[ e.col ] );
+    if ( traffic > 0 )
+      episode_bw.set_elem( e.row, e.col, e.value / traffic * bwxstep_per_port );
   }
   return ExitStatus::SUCCESS;
 }
 
-//ExitStatus ElectricalSwitch::allocate_episode_bw( ) {
-//  tm_estimator->update_tm_est( );
-//  Matrix2D< double > match( num_gpus, num_gpus );
-//  find_matchings( tm_estimator->tm_est, match ).ok( );
-//  for ( int dst = 0; dst < num_gpus; dst ++ ) {
-//    for ( int src = 0; src < num_gpus; src ++ ) {
-////      episode_bw[ src ][ dst ] = match[ src ][ dst ] * bwxstep_per_port;
-//      episode_bw.set_elem( src, dst, match.get_elem( src, dst ) * bwxstep_per_port );
-//    }
-//  }
-//  return ExitStatus::SUCCESS;
-//}
-
 ExitStatus ElectricalSwitch::offline_bw_est( std::unordered_map< Device *,
                                                                  std::unordered_map< Device *, double>> &estimate ) {
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
-    for ( uint16_t j = 0; j < num_gpus; j ++ ) {
+  for ( DeviceId i = 0; i < num_gpus; i ++ ) {
+    for ( DeviceId j = 0; j < num_gpus; j ++ ) {
       estimate[ &gpus[ i ]][ &gpus[ j ]] = bwxstep_per_port;
     }
   }
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus ElectricalSwitch::is_routing_feasible( Packet*, bool &is_feasible ){
+ExitStatus ElectricalSwitch::admit( DeviceId, DeviceId, const PairQueue &queue, Step now, size_t &num_pkts, uint64_t &num_bytes ){
 //  is_bw_avail = ( step_bytes_budget.get_elem( pkt->src, pkt->dst ) >= pkt->num_bytes );
-  is_feasible = true;
-  return ExitStatus::SUCCESS;
-}
\ No newline at end of file
+  return admissible_prefix( queue, unlimited_bytes, now, num_pkts, num_bytes );
+}
+
+template class RoutedInterconnect< ElectricalSwitch >;
@@ -3,8 +3,8 @@
 ExitStatus FullMeshInterconnect::offline_bw_est( std::unordered_map< Device *,
                                                                      std::unordered_map< Device *,
                                                                                          double>> &estimate ) {
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
-    for ( uint16_t j = 0; j < num_gpus; j ++ ) {
+  for ( DeviceId i = 0; i < num_gpus; i ++ ) {
+    for ( DeviceId j = 0; j < num_gpus; j ++ ) {
       estimate[ &gpus[ i ]][ &gpus[ j ]] = cnfg.num_waves * cnfg.bwxstep_per_wave / num_gpus;
     }
   }
@@ -14,15 +14,17 @@ ExitStatus FullMeshInterconnect::offline_bw_est( std::unordered_map< Device *,
 ExitStatus FullMeshInterconnect::allocate_episode_bw( ) {
   /* Make sure it is the right time to make new bandwidth decisions */
   assert( curr_step % cnfg.dec_interval == 0 );
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
-    for ( uint16_t j = 0; j < num_gpus; j ++ ) {
-      episode_bw.set_elem( i, j, double( cnfg.num_waves ) * cnfg.bwxstep_per_wave / num_gpus );
-    }
+  /* every pair owns a fixed share of the port; only record it for the
+   * pairs that are expected to carry traffic */
+  episode_bw.fill_zeros( );
+  for ( const auto &e : tm_estimator->tm_est ) {
+    episode_bw.set_elem( e.row, e.col, double( cnfg.num_waves ) * cnfg.bwxstep_per_wave / num_gpus );
   }
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus FullMeshInterconnect::is_routing_feasible( Packet*, bool &is_feasible ){
-  is_feasible = true;
-  return ExitStatus::SUCCESS;
-}
\ No newline at end of file
+ExitStatus FullMeshInterconnect::admit( DeviceId, DeviceId, const PairQueue &queue, Step now, size_t &num_pkts, uint64_t &num_bytes ){
+  return admissible_prefix( queue, unlimited_bytes, now, num_pkts, num_bytes );
+}
+
+template class RoutedInterconnect< FullMeshInterconnect >;
@@ -2,7 +2,7 @@
 
 ExitStatus MordiaInterconnect::setup_ilp_solver( ) {
 #ifdef HAVE_GUROBI
-  Matrix2D< double > normal_tm( num_gpus, num_gpus );
+  SparseMatrix2D< double > normal_tm( num_gpus, num_gpus );
   normalize_tm( normal_tm );
 
   /* Create an environment */
@@ -99,7 +99,7 @@ ExitStatus MordiaInterconnect::setup_ilp_solver( ) {
 
 ExitStatus MordiaInterconnect::allocate_episode_bw( ) {
 #ifdef HAVE_GUROBI
-  Matrix2D< double > normal_tm( num_gpus, num_gpus );
+  SparseMatrix2D< double > normal_tm( num_gpus, num_gpus );
   normalize_tm( normal_tm );
   model->reset( ); /* reset solution states */
   for ( int src = 0; src < num_gpus; src ++ ) {
@@ -151,30 +151,30 @@ ExitStatus MordiaInterconnect::allocate_episode_bw( ) {
 
 ExitStatus MordiaInterconnect::offline_bw_est( std::unordered_map< Device *,
                                                                    std::unordered_map< Device *, double>> &estimate ) {
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
-    for ( uint16_t j = 0; j < num_gpus; j ++ ) {
+  for ( DeviceId i = 0; i < num_gpus; i ++ ) {
+    for ( DeviceId j = 0; j < num_gpus; j ++ ) {
       estimate[ &gpus[ i ]][ &gpus[ j ]] = cnfg.num_waves * cnfg.bwxstep_per_wave / double( num_gpus );
     }
   }
   return ExitStatus::SUCCESS;
 }
 
-MordiaInterconnect::MordiaInterconnect( uint16_t dev_id,
+MordiaInterconnect::MordiaInterconnect( DeviceId dev_id,
                                         GPU *gpus,
-                                        uint16_t num_gpus,
+                                        DeviceId num_gpus,
                                         double ingress_link_speed,
                                         double egress_link_speed,
                                         TMEstimatorBase *tm_estimator,
                                         const SimConfig &cnfg,
                                         const uint16_t num_waves,
-                                        const std::string log_dir ) : BaseInterconnect( dev_id,
-                                                                                        gpus,
-                                                                                        num_gpus,
-                                                                                        ingress_link_speed,
-                                                                                        egress_link_speed,
-                                                                                        tm_estimator,
-                                                                                        cnfg,
-                                                                                        log_dir ),
+                                        const std::string log_dir ) : RoutedInterconnect< MordiaInterconnect >( dev_id,
+                                                                                                                gpus,
+                                                                                                                num_gpus,
+                                                                                                                ingress_link_speed,
+                                                                                                                egress_link_speed,
+                                                                                                                tm_estimator,
+                                                                                                                cnfg,
+                                                                                                                log_dir ),
 #ifdef HAVE_GUROBI
                                                                                         env( nullptr ),
                                                                                         model( nullptr ),
@@ -202,7 +202,9 @@ MordiaInterconnect::~MordiaInterconnect( ) {
 #endif //HAVE_GUROBI
 }
 
-ExitStatus MordiaInterconnect::is_routing_feasible( Packet*, bool & ){
-  throw std::runtime_error( "is_routing_feasible is not implemented for mordia." ); //ToDo: implement
+ExitStatus MordiaInterconnect::admit( DeviceId, DeviceId, const PairQueue &, Step, size_t &, uint64_t & ){
+  throw std::runtime_error( "admit is not implemented for mordia." ); //ToDo: implement
   return ExitStatus::SUCCESS;
-}
\ No newline at end of file
+}
+
+template class RoutedInterconnect< MordiaInterconnect >;
@@ -3,11 +3,11 @@
 #ifdef HAVE_GUROBI
 #include <gurobi_c++.h>
 #endif // HAVE_GUROBI
-#include "base_interconnect.hh"
+#include "routed_interconnect.hh"
 
 using namespace std;
 
-class MordiaInterconnect : public BaseInterconnect {
+class MordiaInterconnect : public RoutedInterconnect< MordiaInterconnect > {
  private:
 #ifdef HAVE_GUROBI
 GRBEnv *env;
@@ -17,9 +17,9 @@ GRBEnv *env;
  public:
   const uint16_t num_waves;
  public:
-  MordiaInterconnect( uint16_t dev_id,
+  MordiaInterconnect( DeviceId dev_id,
                       GPU *gpus,
-                      uint16_t num_gpus,
+                      DeviceId num_gpus,
                       double ingress_link_speed,
                       double egress_link_speed,
                       TMEstimatorBase *tm_estimator,
@@ -33,7 +33,7 @@ GRBEnv *env;
 
   ExitStatus offline_bw_est( std::unordered_map< Device *, std::unordered_map< Device *, double>> &estimate ) override;
 
-  ExitStatus is_routing_feasible( Packet* pkt, bool &is_feasible ) override;
+  ExitStatus admit( DeviceId src, DeviceId dst, const PairQueue &queue, Step now, size_t &num_pkts, uint64_t &num_bytes );
 
   virtual ~MordiaInterconnect( );
 
@@ -43,4 +43,6 @@ GRBEnv *env;
   ExitStatus allocate_episode_bw( ) override;
 };
 
+extern template class RoutedInterconnect< MordiaInterconnect >;
+
 #endif //ROSTAM_SRC_INTERCONNECT_MORDIA_HH_
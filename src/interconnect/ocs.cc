@@ -9,6 +9,7 @@ ExitStatus OCSInterconnect::allocate_episode_bw( ) {
   else{
     allocate_episode_bw_multishot( ).ok( );
   }
+  episode_bw_budget.assign( episode_bw );
   return ExitStatus::SUCCESS;
 }
 
@@ -25,7 +26,7 @@ ExitStatus OCSInterconnect::setup_optimal_solver_singleshot( ) {
 #ifdef HAVE_GUROBI
 
   try {
-    Matrix2D< double > normal_tm( num_gpus, num_gpus );
+    SparseMatrix2D< double > normal_tm( num_gpus, num_gpus );
     normalize_tm( normal_tm );
 //    cout << normal_tm;
 
@@ -92,8 +93,8 @@ ExitStatus OCSInterconnect::setup_optimal_solver_singleshot( ) {
     for ( int src_port = 0; src_port < eff_num_gpus; src_port ++ ) {
       for ( int dst_port = 0; dst_port < eff_num_gpus; dst_port ++ ) {
         for ( int ocs_no = 0; ocs_no < num_ocs; ocs_no ++ ) {
-          uint16_t src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
-          uint16_t dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
+          DeviceId src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
+          DeviceId dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
           bw[ src_dev ][ dst_dev ] += perms[ ocs_no ][ src_port ][ dst_port ];
         }
       }
@@ -121,7 +122,7 @@ ExitStatus OCSInterconnect::setup_optimal_solver_singleshot( ) {
 ExitStatus OCSInterconnect::allocate_episode_bw_singleshot( ) {
 #ifdef HAVE_GUROBI
   try {
-    Matrix2D< double > normal_tm( num_gpus, num_gpus );
+    SparseMatrix2D< double > normal_tm( num_gpus, num_gpus );
     normalize_tm( normal_tm );
     model->reset( ); /* reset solution states */
     /* create device-to-device bandwidths */
@@ -136,8 +137,8 @@ ExitStatus OCSInterconnect::allocate_episode_bw_singleshot( ) {
     for ( int src_port = 0; src_port < eff_num_gpus; src_port ++ ) {
       for ( int dst_port = 0; dst_port < eff_num_gpus; dst_port ++ ) {
         for ( int ocs_no = 0; ocs_no < num_ocs; ocs_no ++ ) {
-          uint16_t src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
-          uint16_t dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
+          DeviceId src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
+          DeviceId dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
           bw[ src_dev ][ dst_dev ] += model->getVarByName( "perm_" + to_string( ocs_no ) +
               "_" + to_string( src_port ) +
               "_" + to_string( dst_port ));
@@ -181,14 +182,13 @@ ExitStatus OCSInterconnect::allocate_episode_bw_singleshot( ) {
     for ( int src_port = 0; src_port < eff_num_gpus; src_port ++ ) {
       for ( int dst_port = 0; dst_port < eff_num_gpus; dst_port ++ ) {
         for ( int ocs_no = 0; ocs_no < num_ocs; ocs_no ++ ) {
-          uint16_t src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
-          uint16_t dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
+          DeviceId src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
+          DeviceId dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
           bool is_connected = model->getVarByName( "perm_" + to_string( ocs_no ) +
               "_" + to_string( src_port ) +
               "_" + to_string( dst_port )).get( GRB_DoubleAttr_X );
           if ( is_connected ){
             episode_bw.add_elem_by( src_dev, dst_dev, delta);
-            sparse_episode_bw[ src_dev ][ dst_dev ] += delta;
           }
         }
       }
@@ -215,7 +215,7 @@ ExitStatus OCSInterconnect::setup_optimal_solver_multishot( ) {
 #ifdef HAVE_GUROBI
 
   try {
-    Matrix2D< double > normal_tm( num_gpus, num_gpus );
+    SparseMatrix2D< double > normal_tm( num_gpus, num_gpus );
     normalize_tm( normal_tm );
     cout << "eff_num_gpus=" << eff_num_gpus << endl;
     model->set( GRB_IntParam_OutputFlag, 0 );
@@ -274,8 +274,8 @@ ExitStatus OCSInterconnect::setup_optimal_solver_multishot( ) {
     for ( int src_port = 0; src_port < eff_num_gpus; src_port ++ ) {
       for ( int dst_port = 0; dst_port < eff_num_gpus; dst_port ++ ) {
         for ( int ocs_no = 0; ocs_no < num_ocs; ocs_no ++ ) {
-          uint16_t src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
-          uint16_t dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
+          DeviceId src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
+          DeviceId dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
           bw[ src_dev ][ dst_dev ] += perms[ ocs_no ][ src_port ][ dst_port ];
         }
       }
@@ -305,7 +305,7 @@ ExitStatus OCSInterconnect::setup_optimal_solver_multishot( ) {
 ExitStatus OCSInterconnect::allocate_episode_bw_multishot( ) {
 #ifdef HAVE_GUROBI
   try {
-    Matrix2D< double > normal_tm( num_gpus, num_gpus );
+    SparseMatrix2D< double > normal_tm( num_gpus, num_gpus );
     normalize_tm( normal_tm );
     model->reset( ); /* reset solution states */
     /* create device-to-device bandwidths */
@@ -320,8 +320,8 @@ ExitStatus OCSInterconnect::allocate_episode_bw_multishot( ) {
     for ( int src_port = 0; src_port < eff_num_gpus; src_port ++ ) {
       for ( int dst_port = 0; dst_port < eff_num_gpus; dst_port ++ ) {
         for ( int ocs_no = 0; ocs_no < num_ocs; ocs_no ++ ) {
-          uint16_t src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
-          uint16_t dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
+          DeviceId src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
+          DeviceId dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
           bw[ src_dev ][ dst_dev ] += model->getVarByName( "perm_" + to_string( ocs_no ) +
               "_" + to_string( src_port ) +
               "_" + to_string( dst_port ));
@@ -349,14 +349,13 @@ ExitStatus OCSInterconnect::allocate_episode_bw_multishot( ) {
     for ( int src_port = 0; src_port < eff_num_gpus; src_port ++ ) {
       for ( int dst_port = 0; dst_port < eff_num_gpus; dst_port ++ ) {
         for ( int ocs_no = 0; ocs_no < num_ocs; ocs_no ++ ) {
-          uint16_t src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
-          uint16_t dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
+          DeviceId src_dev = port_map.at( ocs_no ).at( src_port )->dev_id;
+          DeviceId dst_dev = port_map.at( ocs_no ).at( dst_port )->dev_id;
           bool is_connected = model->getVarByName( "perm_" + to_string( ocs_no ) +
               "_" + to_string( src_port ) +
               "_" + to_string( dst_port )).get( GRB_DoubleAttr_X );
           if ( is_connected ){
             episode_bw.add_elem_by( src_dev, dst_dev, delta);
-            sparse_episode_bw[ src_dev ][ dst_dev ] += delta;
           }
         }
       }
@@ -373,8 +372,8 @@ ExitStatus OCSInterconnect::allocate_episode_bw_multishot( ) {
 }
 
 ExitStatus OCSInterconnect::offline_bw_est( unordered_map< Device *, unordered_map< Device *, double>> &estimate ) {
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
-    for ( uint16_t j = 0; j < num_gpus; j ++ ) {
+  for ( DeviceId i = 0; i < num_gpus; i ++ ) {
+    for ( DeviceId j = 0; j < num_gpus; j ++ ) {
 //      estimate[ &gpus[ i ] ][ &gpus[ j ] ] = cnfg.num_waves * cnfg.bwxstep_per_wave / double( num_ocs ); // generates runtime lowerbound
       estimate[ &gpus[ i ] ][ &gpus[ j ] ] = cnfg.num_waves * cnfg.bwxstep_per_wave / 8.0; // generates runtime lowerbound
       if (( i > num_ocs || j > num_ocs ))//&& single_shot
@@ -384,35 +383,29 @@ ExitStatus OCSInterconnect::offline_bw_est( unordered_map< Device *, unordered_m
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus OCSInterconnect::reset_routing_step_counters( ){
-  for ( auto &s : sparse_episode_bw ){
-    for ( auto &d : s.second ){
-      sparse_episode_bw_budget[ s.first ][ d.first ] = d.second;
-    }
-  }
-  return ExitStatus::SUCCESS;
-}
-
-ExitStatus OCSInterconnect::is_routing_feasible( Packet* pkt, bool &is_bw_avail ){
-  if ( curr_step % ( cnfg.dec_interval + cnfg.interconnect_reconf_delay ) < cnfg.interconnect_reconf_delay ) {
+ExitStatus OCSInterconnect::admit( DeviceId src,
+                                   DeviceId dst,
+                                   const PairQueue &queue,
+                                   Step now,
+                                   size_t &num_pkts,
+                                   uint64_t &num_bytes ){
+  if ( now % ( cnfg.dec_interval + cnfg.interconnect_reconf_delay ) < cnfg.interconnect_reconf_delay ) {
     /* we are still in interconnect transition mode; no packet transfer is feasible */
-    is_bw_avail = false;
+    num_pkts = 0;
+    num_bytes = 0;
     return ExitStatus::SUCCESS;
   }
 
-  try {
-    is_bw_avail = ( sparse_episode_bw_budget.at( pkt->src->dev_id ).at( pkt->dst->dev_id ) >= pkt->num_bytes );
-    if ( is_bw_avail )
-      sparse_episode_bw_budget.at( pkt->src->dev_id ).at( pkt->dst->dev_id ) -= pkt->num_bytes;
-  }
-  catch ( const std::out_of_range& oor ) {
-    is_bw_avail = false;
-  }
-
+  const int64_t pair = episode_bw_budget.id( src, dst, queue.budget_id );
+  admissible_prefix( queue, episode_bw_budget.available( pair, now ), now, num_pkts, num_bytes ).ok( );
+  if ( num_bytes > 0 )
+    episode_bw_budget.charge( pair, now, num_bytes );
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus OCSInterconnect::set_eff_num_gpus( const uint16_t n ) {
+ExitStatus OCSInterconnect::set_eff_num_gpus( const DeviceId n ) {
   eff_num_gpus = n;
   return ExitStatus::SUCCESS;
 }
+
+template class RoutedInterconnect< OCSInterconnect >;
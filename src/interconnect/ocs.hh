@@ -1,16 +1,17 @@
 #ifndef SIPML_SRC_OCS_HH_
 #define SIPML_SRC_OCS_HH_
-#include "base_interconnect.hh"
+#include "routed_interconnect.hh"
+#include "pair_budget.hh"
 
 using namespace std;
 
-class OCSInterconnect : public BaseInterconnect {
+class OCSInterconnect : public RoutedInterconnect< OCSInterconnect > {
  private:
 #ifdef HAVE_GUROBI
   GRBModel *model;
 #endif
-  std::map< uint16_t, std::map< uint16_t, double > > sparse_episode_bw_budget;
-  uint16_t eff_num_gpus; /* effective number of GPUs for speeding up the ILP solver */
+  PairBudget episode_bw_budget; /* per-step budgets of the pairs in episode_bw */
+  DeviceId eff_num_gpus; /* effective number of GPUs for speeding up the ILP solver */
 
  public:
   const uint16_t num_ocs;
@@ -30,9 +31,9 @@ class OCSInterconnect : public BaseInterconnect {
   ExitStatus allocate_episode_bw_multishot( );
 
  public:
-  OCSInterconnect( uint16_t dev_id,
+  OCSInterconnect( DeviceId dev_id,
                    GPU *gpus,
-                   uint16_t num_gpus,
+                   DeviceId num_gpus,
                    double ingress_link_speed,
                    double egress_link_speed,
                    TMEstimatorBase *tm_estimator,
@@ -40,17 +41,18 @@ class OCSInterconnect : public BaseInterconnect {
                    const uint16_t num_ocs,
                    const uint16_t port_count,
                    const bool single_shot,
-                   const std::string log_dir ) : BaseInterconnect( dev_id,
-                                                                   gpus,
-                                                                   num_gpus,
-                                                                   ingress_link_speed,
-                                                                   egress_link_speed,
-                                                                   tm_estimator,
-                                                                   cnfg,
-                                                                   log_dir ),
+                   const std::string log_dir ) : RoutedInterconnect< OCSInterconnect >( dev_id,
+                                                                                        gpus,
+                                                                                        num_gpus,
+                                                                                        ingress_link_speed,
+                                                                                        egress_link_speed,
+                                                                                        tm_estimator,
+                                                                                        cnfg,
+                                                                                        log_dir ),
 #ifdef HAVE_GUROBI
                                                  model( nullptr ),
 #endif //HAVE_GUROBI
+                                                 episode_bw_budget( ),
                                                  num_ocs( num_ocs ),
                                                  port_count( port_count ),
                                                  single_shot( single_shot ),
@@ -92,12 +94,12 @@ class OCSInterconnect : public BaseInterconnect {
 
   ExitStatus offline_bw_est( unordered_map< Device *, unordered_map< Device *, double>> &estimate ) override;
 
-  ExitStatus is_routing_feasible( Packet* pkt, bool &is_feasible ) override;
+  ExitStatus admit( DeviceId src, DeviceId dst, const PairQueue &queue, Step now, size_t &num_pkts, uint64_t &num_bytes );
 
-  ExitStatus reset_routing_step_counters( ) override;
-
-  ExitStatus set_eff_num_gpus( uint16_t n );
+  ExitStatus set_eff_num_gpus( DeviceId n );
 
 };
 
+extern template class RoutedInterconnect< OCSInterconnect >;
+
 #endif //SIPML_SRC_OCS_HH_
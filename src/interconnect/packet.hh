@@ -13,19 +13,22 @@ class Packet {
   const uint16_t num_bytes;
   Step tx_time;
   Step rx_time;
+  /* the step egress handed the packet to its gpu, no earlier than rx_time
+   * when the egress budget holds it back */
+  Step egress_time;
   const static uint16_t max_pkt_size; /* in bytes */
-  static uint64_t num_pkts;
   PacketId pkt_id;
   bool acked;
+  Packet *next; /* intrusive link; owned by the PacketQueue holding the packet */
  public:
-  Packet( Device *src, Device *dst, uint32_t numBytes, Step txTime ) : src( src ), dst( dst ),
+  Packet( Device *src, Device *dst, uint32_t numBytes, Step txTime, PacketId pktId ) : src( src ), dst( dst ),
                                                                        num_bytes( numBytes ),
                                                                        tx_time( txTime ),
                                                                        rx_time( std::numeric_limits< Step >::max( )),
-                                                                       pkt_id( num_pkts ),
-                                                                       acked( false ) {
-    num_pkts ++;
-  }
+                                                                       egress_time( std::numeric_limits< Step >::max( )),
+                                                                       pkt_id( pktId ),
+                                                                       acked( false ),
+                                                                       next( nullptr ) { }
 
  private:
   /* unnecessary copies may slow down the simulator */
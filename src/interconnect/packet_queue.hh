@@ -0,0 +1,121 @@
+#ifndef ROSTAM_SRC_INTERCONNECT_PACKET_QUEUE_HH_
+#define ROSTAM_SRC_INTERCONNECT_PACKET_QUEUE_HH_
+#include <assert.h>
+#include <cstddef>
+#include "packet.hh"
+
+/* FIFO of packets linked through Packet::next. A packet is in at most one
+ * queue at a time, so moving packets between the transport, gpu and
+ * interconnect stages needs no allocation, and handing over a whole queue
+ * (or a prefix of it) is pointer surgery. The queue does not own the
+ * packets. */
+class PacketQueue {
+ private:
+  Packet *head;
+  Packet *tail;
+  size_t count;
+
+ public:
+  class const_iterator {
+   private:
+    Packet *pkt;
+   public:
+    explicit const_iterator( Packet *pkt ) : pkt( pkt ) { }
+
+    /* like a deque< Packet * >, a const queue still hands out mutable packets */
+    Packet *operator*( ) const { return pkt; }
+
+    const_iterator &operator++( ) {
+      pkt = pkt->next;
+      return *this;
+    }
+
+    bool operator!=( const const_iterator &other ) const { return pkt != other.pkt; }
+  };
+
+ public:
+  PacketQueue( ) : head( nullptr ), tail( nullptr ), count( 0 ) { }
+
+  PacketQueue( PacketQueue &&other ) noexcept : head( other.head ), tail( other.tail ), count( other.count ) {
+    other.head = nullptr;
+    other.tail = nullptr;
+    other.count = 0;
+  }
+
+  PacketQueue( const PacketQueue & ) = delete;
+
+  PacketQueue &operator=( const PacketQueue & ) = delete;
+
+  bool empty( ) const { return head == nullptr; }
+
+  size_t size( ) const { return count; }
+
+  Packet *front( ) const { return head; }
+
+  Packet *back( ) const { return tail; }
+
+  const_iterator begin( ) const { return const_iterator( head ); }
+
+  const_iterator end( ) const { return const_iterator( nullptr ); }
+
+  void push_back( Packet *pkt ) {
+    pkt->next = nullptr;
+    if ( tail == nullptr )
+      head = pkt;
+    else
+      tail->next = pkt;
+    tail = pkt;
+    count ++;
+  }
+
+  void pop_front( ) {
+    assert( head != nullptr );
+    Packet *pkt = head;
+    head = pkt->next;
+    if ( head == nullptr )
+      tail = nullptr;
+    pkt->next = nullptr;
+    count --;
+  }
+
+  /* move all of other's packets to the back of this queue in O(1) */
+  void splice_back( PacketQueue &other ) {
+    if ( other.empty( ))
+      return;
+    if ( tail == nullptr )
+      head = other.head;
+    else
+      tail->next = other.head;
+    tail = other.tail;
+    count += other.count;
+    other.head = nullptr;
+    other.tail = nullptr;
+    other.count = 0;
+  }
+
+  /* move the first num_pkts of other's packets to the back of this queue;
+   * only walks the moved prefix */
+  void splice_back( PacketQueue &other, size_t num_pkts ) {
+    assert( num_pkts <= other.count );
+    if ( num_pkts == other.count ) {
+      splice_back( other );
+      return;
+    }
+    if ( num_pkts == 0 )
+      return;
+    Packet *last = other.head;
+    for ( size_t i = 1; i < num_pkts; i ++ )
+      last = last->next;
+    if ( tail == nullptr )
+      head = other.head;
+    else
+      tail->next = other.head;
+    tail = last;
+    count += num_pkts;
+    other.head = last->next;
+    other.count -= num_pkts;
+    last->next = nullptr;
+  }
+};
+
+#endif //ROSTAM_SRC_INTERCONNECT_PACKET_QUEUE_HH_
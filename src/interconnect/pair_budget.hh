@@ -0,0 +1,91 @@
+#ifndef ROSTAM_SRC_INTERCONNECT_PAIR_BUDGET_HH_
+#define ROSTAM_SRC_INTERCONNECT_PAIR_BUDGET_HH_
+#include <assert.h>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "device.hh"
+#include "sparse_matrix.hh"
+
+/* a pair's id in a PairBudget, cached by the pair's queue: valid while
+ * epoch matches the budget's, i.e. until the next episode is assigned */
+struct PairBudgetId {
+  int64_t id = - 1;
+  uint64_t epoch = 0;
+};
+
+/* Per-step byte budgets of the gpu pairs that have bandwidth in the current
+ * episode. Each allocated pair gets a dense id when the episode starts and
+ * its budget lives in a flat array; a budget is refilled the first time its
+ * pair is touched in a new step. A pair's id is looked up once per episode
+ * and then kept in its PairBudgetId, so admitting packets does no hashing.
+ * Steps are passed in rather than kept here, so distinct pairs may be used
+ * from different threads, each at its own step. */
+class PairBudget {
+ private:
+  uint64_t epoch;                                   /* bumped by assign( ) */
+  std::unordered_map< uint64_t, uint32_t > pair_id; /* (src, dst) key -> active-pair id */
+  std::vector< double > episode_alloc;              /* bytes per step, by pair id */
+  std::vector< double > budget;                     /* bytes left in the current step */
+  std::vector< uint64_t > budget_step;              /* step + 1 at which budget was last refilled */
+
+  static uint64_t key( DeviceId src, DeviceId dst ) {
+    return ( uint64_t( src ) << 32 ) | uint64_t( dst );
+  }
+
+ public:
+  PairBudget( ) : epoch( 1 ), pair_id( ), episode_alloc( ), budget( ), budget_step( ) { }
+
+  /* rebuild the active pairs from a new episode allocation */
+  void assign( const SparseMatrix2D< double > &episode_bw ) {
+    epoch ++;
+    pair_id.clear( );
+    episode_alloc.clear( );
+    for ( const auto &e : episode_bw ) {
+      pair_id.emplace( key( e.row, e.col ), uint32_t( episode_alloc.size( )));
+      episode_alloc.push_back( e.value );
+    }
+    budget.assign( episode_alloc.size( ), 0 );
+    budget_step.assign( episode_alloc.size( ), 0 );
+  }
+
+  /* the pair's active-pair id, - 1 without an allocation; looked up only
+   * when cached is from an earlier episode */
+  int64_t id( DeviceId src, DeviceId dst, PairBudgetId &cached ) const {
+    if ( cached.epoch != epoch ) {
+      cached.id = find( src, dst );
+      cached.epoch = epoch;
+    }
+    return cached.id;
+  }
+
+  /* bytes pair id may still send in step; pairs without an allocation
+   * have none */
+  double available( int64_t id, Step step ) {
+    return ( id < 0 ? 0 : refilled( size_t( id ), step ));
+  }
+
+  /* take num_bytes, which must fit in available( id, step ) */
+  void charge( int64_t id, Step step, double num_bytes ) {
+    assert( id >= 0 );
+    double &left = refilled( size_t( id ), step );
+    assert( left >= num_bytes );
+    left -= num_bytes;
+  }
+
+ private:
+  int64_t find( DeviceId src, DeviceId dst ) const {
+    auto it = pair_id.find( key( src, dst ));
+    return ( it == pair_id.end( ) ? - 1 : int64_t( it->second ));
+  }
+
+  double &refilled( size_t id, Step step ) {
+    if ( budget_step[ id ] != uint64_t( step ) + 1 ) {
+      budget[ id ] = episode_alloc[ id ];
+      budget_step[ id ] = uint64_t( step ) + 1;
+    }
+    return budget[ id ];
+  }
+};
+
+#endif //ROSTAM_SRC_INTERCONNECT_PAIR_BUDGET_HH_
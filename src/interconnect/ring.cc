@@ -1,10 +1,11 @@
 #include "ring.hh"
 #include "graph.hh"
+#include "matrix.hh"
 
 ExitStatus RingInterconnect::setup_ilp_solver( ) {
 #ifdef HAVE_GUROBI
 
-  Matrix2D< double > normal_tm( eff_num_gpus, eff_num_gpus );
+  SparseMatrix2D< double > normal_tm( eff_num_gpus, eff_num_gpus );
   normalize_tm( normal_tm );
 
   /* Create an environment */
@@ -131,7 +132,7 @@ ExitStatus RingInterconnect::setup_ilp_solver( ) {
 ExitStatus RingInterconnect::allocate_episode_bw_ilp( ) {
 #ifdef HAVE_GUROBI
 
-  Matrix2D< double > normal_tm( eff_num_gpus, eff_num_gpus );
+  SparseMatrix2D< double > normal_tm( eff_num_gpus, eff_num_gpus );
   normalize_tm( normal_tm );
 //  cout << normal_tm << endl;
   model->reset( ); /* reset solution states */
@@ -200,15 +201,6 @@ ExitStatus RingInterconnect::allocate_episode_bw_ilp( ) {
       }
     }
   }
-  for ( int src = 0; src < eff_num_gpus; src ++ ) {
-    for ( int dst = 0; dst < eff_num_gpus; dst ++ ) {
-      double bitrate = episode_bw.get_elem(src, dst);
-      bool is_connected = ( bitrate > 0);
-      if ( is_connected ) {
-        sparse_episode_bw[ src ][ dst ] = bitrate;
-      }
-      }
-  }
 //  for ( int src = 0; src < eff_num_gpus; src ++ ) {
 //    for ( int dst = 0; dst < eff_num_gpus; dst ++ ) {
 //      double bitrate = episode_bw.get_elem( src, dst );
@@ -224,17 +216,17 @@ ExitStatus RingInterconnect::allocate_episode_bw_ilp( ) {
 ExitStatus RingInterconnect::allocate_episode_bw_mcf( ) {
 #ifdef HAVE_GUROBI
 
-  Matrix2D< double > normal_tm( eff_num_gpus, eff_num_gpus );
+  SparseMatrix2D< double > normal_tm( eff_num_gpus, eff_num_gpus );
   normalize_tm( normal_tm );
   try {
     GRBModel mcf_model = GRBModel( GRBEnv( ));
     mcf_model.set( GRB_IntParam_OutputFlag, 0 );
     const double capacity = 1.0;
-    uint16_t src;
-    uint16_t dst;
-    using EdgeWeight = tuple< uint16_t, uint16_t, double >;
+    DeviceId src;
+    DeviceId dst;
+    using EdgeWeight = tuple< DeviceId, DeviceId, double >;
     vector< EdgeWeight > flow_weights;
-    Graph< uint16_t > flow_graph;
+    Graph< DeviceId > flow_graph;
     for ( src = 0; src < eff_num_gpus; src ++ ) {
       for ( dst = 0; dst < eff_num_gpus; dst ++ ) {
         if ( normal_tm.get_elem( src, dst ) > 0 ) {
@@ -307,7 +299,7 @@ ExitStatus RingInterconnect::allocate_episode_bw_mcf( ) {
           .get( GRB_DoubleAttr_X ) / wave_inv;
       auto rounded_alloc = uint16_t( alloc );
       double diff = alloc - rounded_alloc;
-      double r = (( double ) rand( ) / ( RAND_MAX ));
+      double r = std::uniform_real_distribution< double >( 0, 1 )( gpus[ 0 ].ctx->rng );
       alloc = ( r > diff ? alloc : alloc + 1 );
       allocation.set_elem( src, dst, alloc );
     }
@@ -357,13 +349,14 @@ ExitStatus RingInterconnect::allocate_episode_bw( ) {
     default:throw runtime_error( "Not implemented this type of bandwidth decsion making for RingInterconnect." );
   }
 #endif //HAVE_GUROBI
+  episode_bw_budget.assign( episode_bw );
   return ExitStatus::SUCCESS;
 }
 
 ExitStatus RingInterconnect::offline_bw_est( std::unordered_map< Device *,
                                                                  std::unordered_map< Device *, double>> &estimate ) {
-  for ( uint16_t i = 0; i < num_gpus; i ++ ) {
-    for ( uint16_t j = 0; j < num_gpus; j ++ ) {
+  for ( DeviceId i = 0; i < num_gpus; i ++ ) {
+    for ( DeviceId j = 0; j < num_gpus; j ++ ) {
       estimate[ &gpus[ i ]][ &gpus[ j ]] = cnfg.num_waves * cnfg.bwxstep_per_wave;
     }
   }
@@ -372,9 +365,9 @@ ExitStatus RingInterconnect::offline_bw_est( std::unordered_map< Device *,
   return ExitStatus::SUCCESS;
 }
 
-RingInterconnect::RingInterconnect( uint16_t dev_id,
+RingInterconnect::RingInterconnect( DeviceId dev_id,
                                     GPU *gpus,
-                                    uint16_t num_gpus,
+                                    DeviceId num_gpus,
                                     double ingress_link_speed,
                                     double egress_link_speed,
                                     TMEstimatorBase *tm_estimator,
@@ -383,19 +376,20 @@ RingInterconnect::RingInterconnect( uint16_t dev_id,
                                     const BWDecisionType bw_decision_type,
                                     const int tolerable_dist,
                                     const int num_rings,
-                                    const std::string log_dir ) : BaseInterconnect( dev_id,
-                                                                                    gpus,
-                                                                                    num_gpus,
-                                                                                    ingress_link_speed,
-                                                                                    egress_link_speed,
-                                                                                    tm_estimator,
-                                                                                    cnfg,
-                                                                                    log_dir ),
+                                    const std::string log_dir ) : RoutedInterconnect< RingInterconnect >( dev_id,
+                                                                                                          gpus,
+                                                                                                          num_gpus,
+                                                                                                          ingress_link_speed,
+                                                                                                          egress_link_speed,
+                                                                                                          tm_estimator,
+                                                                                                          cnfg,
+                                                                                                          log_dir ),
 #ifdef HAVE_GUROBI
                                                                   env( nullptr ),
                                                                   model( nullptr ),
                                                                   lambda( nullptr ),
 #endif //HAVE_GUROBI
+                                                                  episode_bw_budget( ),
                                                                   num_waves( num_waves ),
                                                                   bw_decision_type( bw_decision_type ),
                                                                   tolerable_dist( tolerable_dist ),
@@ -406,34 +400,29 @@ RingInterconnect::RingInterconnect( uint16_t dev_id,
 RingInterconnect::~RingInterconnect( ) {
 }
 
-ExitStatus RingInterconnect::reset_routing_step_counters( ){
-  for ( auto &s : sparse_episode_bw ){
-    for ( auto &d : s.second ){
-      sparse_episode_bw_budget[ s.first ][ d.first ] = d.second;
-    }
-  }
-  return ExitStatus::SUCCESS;
-}
-
-ExitStatus RingInterconnect::is_routing_feasible( Packet* pkt, bool &is_bw_avail ){
-  if ( curr_step % ( cnfg.dec_interval + cnfg.interconnect_reconf_delay ) < cnfg.interconnect_reconf_delay ) {
+ExitStatus RingInterconnect::admit( DeviceId src,
+                                    DeviceId dst,
+                                    const PairQueue &queue,
+                                    Step now,
+                                    size_t &num_pkts,
+                                    uint64_t &num_bytes ){
+  if ( now % ( cnfg.dec_interval + cnfg.interconnect_reconf_delay ) < cnfg.interconnect_reconf_delay ) {
     /* we are still in interconnect transition mode; no packet transfer is feasible */
-    is_bw_avail = false;
+    num_pkts = 0;
+    num_bytes = 0;
     return ExitStatus::SUCCESS;
   }
 
-  try {
-    is_bw_avail = ( sparse_episode_bw_budget.at( pkt->src->dev_id ).at( pkt->dst->dev_id ) >= pkt->num_bytes );
-    if ( is_bw_avail )
-      sparse_episode_bw_budget.at( pkt->src->dev_id ).at( pkt->dst->dev_id ) -= pkt->num_bytes;
-  }
-  catch ( const std::out_of_range& oor ) {
-    is_bw_avail = false;
-  }
+  const int64_t pair = episode_bw_budget.id( src, dst, queue.budget_id );
+  admissible_prefix( queue, episode_bw_budget.available( pair, now ), now, num_pkts, num_bytes ).ok( );
+  if ( num_bytes > 0 )
+    episode_bw_budget.charge( pair, now, num_bytes );
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus RingInterconnect::set_eff_num_gpus( uint16_t n ) {
+ExitStatus RingInterconnect::set_eff_num_gpus( DeviceId n ) {
   eff_num_gpus = n;
   return ExitStatus::SUCCESS;
 }
+
+template class RoutedInterconnect< RingInterconnect >;
@@ -1,6 +1,7 @@
 #ifndef ROSTAM_SRC_INTERCONNECT_RING_HH_
 #define ROSTAM_SRC_INTERCONNECT_RING_HH_
-#include "base_interconnect.hh"
+#include "routed_interconnect.hh"
+#include "pair_budget.hh"
 
 using namespace std;
 enum class BWDecisionType {
@@ -8,15 +9,15 @@ enum class BWDecisionType {
   MINCOSTFLOW
 };
 
-class RingInterconnect : public BaseInterconnect {
+class RingInterconnect : public RoutedInterconnect< RingInterconnect > {
  private:
 #ifdef HAVE_GUROBI
 GRBEnv *env;
   GRBModel *model;
   GRBVar ****lambda;
 #endif //HAVE_GUROBI
-  std::map< uint16_t, std::map< uint16_t, double > > sparse_episode_bw_budget;
-  uint16_t eff_num_gpus; /* effective number of GPUs for speeding up the ILP solver */
+  PairBudget episode_bw_budget; /* per-step budgets of the pairs in episode_bw */
+  DeviceId eff_num_gpus; /* effective number of GPUs for speeding up the ILP solver */
 
  public:
   const uint16_t num_waves;
@@ -27,9 +28,9 @@ GRBEnv *env;
   ExitStatus setup_ilp_solver( );
 
  public:
-  RingInterconnect( uint16_t dev_id,
+  RingInterconnect( DeviceId dev_id,
                     GPU *gpus,
-                    uint16_t num_gpus,
+                    DeviceId num_gpus,
                     double ingress_link_speed,
                     double egress_link_speed,
                     TMEstimatorBase *tm_estimator,
@@ -47,11 +48,9 @@ GRBEnv *env;
 
   ExitStatus offline_bw_est( std::unordered_map< Device *, std::unordered_map< Device *, double>> &estimate ) override;
 
-  ExitStatus is_routing_feasible( Packet* pkt, bool &is_feasible ) override;
+  ExitStatus admit( DeviceId src, DeviceId dst, const PairQueue &queue, Step now, size_t &num_pkts, uint64_t &num_bytes );
 
-  ExitStatus set_eff_num_gpus( uint16_t n );
-
-  ExitStatus reset_routing_step_counters( ) override;
+  ExitStatus set_eff_num_gpus( DeviceId n );
 
   virtual ~RingInterconnect( );
 
@@ -63,4 +62,6 @@ GRBEnv *env;
   ExitStatus allocate_episode_bw_mcf( );
 };
 
+extern template class RoutedInterconnect< RingInterconnect >;
+
 #endif //ROSTAM_SRC_INTERCONNECT_RING_HH_
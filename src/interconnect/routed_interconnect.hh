@@ -0,0 +1,146 @@
+#ifndef ROSTAM_SRC_INTERCONNECT_ROUTED_INTERCONNECT_HH_
+#define ROSTAM_SRC_INTERCONNECT_ROUTED_INTERCONNECT_HH_
+#include <limits>
+#include "base_interconnect.hh"
+
+/* Statically dispatched routing loop (CRTP). Interconnect implements
+ *   ExitStatus admit( DeviceId src, DeviceId dst, const PairQueue &queue,
+ *                     Step now, size_t &num_pkts, uint64_t &num_bytes );
+ * which returns how many packets (and bytes) from the front of the pair's
+ * queue may pass in step now; the loop then splices them onto the
+ * receiver's queue. admit( ) is called without going through the vtable,
+ * and each interconnect explicitly instantiates its loop in its own .cc,
+ * next to its definition. With a worker pool, admit( ) is called
+ * concurrently for pairs with different sources, possibly at different
+ * steps (see proceed_window_ahead( )), so it must only keep per-pair state
+ * and take the step from now. */
+template< class Interconnect >
+class RoutedInterconnect : public BaseInterconnect {
+ public:
+  using BaseInterconnect::BaseInterconnect;
+
+ protected:
+  /* the longest prefix of queue whose latency is met in step now and whose
+   * bytes fit in byte_budget; packets are admitted in order, so the first
+   * one that does not fit stops the prefix */
+  ExitStatus admissible_prefix( const PairQueue &queue,
+                                double byte_budget,
+                                Step now,
+                                size_t &num_pkts,
+                                uint64_t &num_bytes ) const;
+
+  static constexpr double unlimited_bytes = std::numeric_limits< double >::infinity( );
+
+ private:
+  /* route the queues of the sources [first, last) in step now, handing
+   * each admitted prefix to routed( dst, pkts, num_pkts ) */
+  template< class Sink >
+  uint64_t route_rows( DeviceId first, DeviceId last, Step now, Sink &&routed );
+
+  ExitStatus proceed_routing( ) final;
+
+  ExitStatus route_window_rows( size_t part, DeviceId first, DeviceId last, Step now ) final;
+};
+
+template< class Interconnect >
+ExitStatus RoutedInterconnect< Interconnect >::admissible_prefix( const PairQueue &queue,
+                                                                  double byte_budget,
+                                                                  Step now,
+                                                                  size_t &num_pkts,
+                                                                  uint64_t &num_bytes ) const {
+  num_pkts = 0;
+  num_bytes = 0;
+  if ( queue.pkts.empty( ))
+    return ExitStatus::SUCCESS;
+  /* the queue is in tx_time order: if its last packet has met the latency
+   * and the whole queue fits, it passes without looking at each packet */
+  if ( queue.pkts.back( )->tx_time + cnfg.interconnect_latency <= now
+      && queue.num_bytes <= byte_budget ) {
+    num_pkts = queue.pkts.size( );
+    num_bytes = queue.num_bytes;
+    return ExitStatus::SUCCESS;
+  }
+  for ( const Packet *pkt : queue.pkts ) {
+    if ( pkt->tx_time + cnfg.interconnect_latency > now
+        || num_bytes + pkt->num_bytes > byte_budget )
+      break;
+    num_pkts ++;
+    num_bytes += pkt->num_bytes;
+  }
+  return ExitStatus::SUCCESS;
+}
+
+template< class Interconnect >
+template< class Sink >
+uint64_t RoutedInterconnect< Interconnect >::route_rows( DeviceId first, DeviceId last, Step now, Sink &&routed ) {
+  auto &interconnect = static_cast< Interconnect & >( *this );
+  size_t num_pkts;
+  uint64_t num_bytes;
+  uint64_t bytes_routed = 0;
+  for ( DeviceId i = first; i < last; i ++ ) {
+    /* destinations are visited in increasing order, as with the dense queues */
+    for ( auto &dst_queue : to_send_buff[ i ] ) {
+      const DeviceId j = dst_queue.first;
+      auto &queue = dst_queue.second;
+      if ( queue.pkts.empty( ))
+        continue;
+      interconnect.admit( i, j, queue, now, num_pkts, num_bytes ).ok( );
+      if ( num_pkts == 0 )
+        continue;
+      assert( queue.pkts.front( )->src->dev_id == i );
+      assert( queue.pkts.front( )->dst->dev_id == j );
+      /* a packet counts as received in the step it is routed, even when
+       * egress holds it back */
+      size_t k = 0;
+      for ( Packet *pkt : queue.pkts ) {
+        if ( k ++ == num_pkts )
+          break;
+        pkt->rx_time = now;
+      }
+      routed( j, queue.pkts, num_pkts );
+      queue.num_bytes -= num_bytes;
+      bytes_routed += num_bytes;
+    }
+  }
+  return bytes_routed;
+}
+
+template< class Interconnect >
+ExitStatus RoutedInterconnect< Interconnect >::proceed_routing( ) {
+  if ( pool == nullptr ) {
+    total_bytes_transferred += route_rows( 0, num_gpus, curr_step, [ this ]( DeviceId j, PacketQueue &pkts, size_t n ) {
+      to_recv_buff[ j ].splice_back( pkts, n );
+    } );
+    return ExitStatus::SUCCESS;
+  }
+  /* each partition routes its own sources into private per-destination
+   * queues; appending them in partition order gives every receiver its
+   * packets in the same order as the serial loop */
+  for_each_partition( [ this ]( size_t part, DeviceId first, DeviceId last ) {
+    auto &dst_queues = routed[ part ];
+    auto &touched = routed_dsts[ part ];
+    routed_bytes[ part ] = route_rows( first, last, curr_step, [ &dst_queues, &touched ]( DeviceId j, PacketQueue &pkts, size_t n ) {
+      if ( dst_queues[ j ].empty( ))
+        touched.push_back( j );
+      dst_queues[ j ].splice_back( pkts, n );
+    } );
+  } ).ok( );
+  for ( size_t part = 0; part < routed.size( ); part ++ ) {
+    for ( DeviceId j : routed_dsts[ part ] )
+      to_recv_buff[ j ].splice_back( routed[ part ][ j ] );
+    routed_dsts[ part ].clear( );
+    total_bytes_transferred += routed_bytes[ part ];
+  }
+  return ExitStatus::SUCCESS;
+}
+
+template< class Interconnect >
+ExitStatus RoutedInterconnect< Interconnect >::route_window_rows( size_t part, DeviceId first, DeviceId last, Step now ) {
+  auto &dst_queues = routed[ part ];
+  routed_bytes[ part ] += route_rows( first, last, now, [ &dst_queues ]( DeviceId j, PacketQueue &pkts, size_t n ) {
+    dst_queues[ j ].splice_back( pkts, n );
+  } );
+  return ExitStatus::SUCCESS;
+}
+
+#endif //ROSTAM_SRC_INTERCONNECT_ROUTED_INTERCONNECT_HH_
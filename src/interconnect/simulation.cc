@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include "simulation.hh"
+#include "interconnect.hh"
+#include "spin_barrier.hh"
+
+static ExitStatus run_serial( Session &session, BaseInterconnect &interconnect, uint64_t max_steps ) {
+  bool done = false;
+  for ( uint64_t it = 0; it < max_steps; it ++ ) {
+    session.proceed( done ).ok( );
+    if ( done )
+      break;
+    interconnect.proceed( ).ok( );
+    session.curr_step ++;
+    interconnect.curr_step ++;
+  }
+  return ExitStatus::SUCCESS;
+}
+
+static ExitStatus run_pipelined( Session &session, BaseInterconnect &interconnect, uint64_t max_steps ) {
+  SpinBarrier session_done( 2 );
+  SpinBarrier step_done( 2 );
+  bool done = false; /* written by the session thread before session_done */
+  PacketQueue arrived; /* handed from the interconnect to the session thread at step_done */
+
+  interconnect.set_deferred_delivery( true ).ok( );
+  std::thread interconnect_thread( [ & ]( ) {
+    for ( uint64_t it = 0; it < max_steps; it ++ ) {
+      /* an episode's traffic matrix must see this step's sends, so at
+       * episode boundaries the whole step waits for the session */
+      const bool episode_start = interconnect.is_episode_start( );
+      if ( ! episode_start ) {
+        interconnect.proceed_ingress_backlog( ).ok( );
+        interconnect.proceed_transfer( ).ok( );
+      }
+      session_done.arrive_and_wait( );
+      if ( done )
+        break;
+      if ( episode_start ) {
+        interconnect.proceed_episode( ).ok( );
+        interconnect.proceed_ingress( ).ok( );
+        interconnect.proceed_transfer( ).ok( );
+      } else {
+        interconnect.proceed_ingress_sent( ).ok( );
+      }
+      interconnect.proceed_log( ).ok( );
+      interconnect.collect_delivered( arrived ).ok( );
+      interconnect.curr_step ++;
+      step_done.arrive_and_wait( );
+    }
+  } );
+
+  for ( uint64_t it = 0; it < max_steps; it ++ ) {
+    interconnect.deliver( arrived ).ok( );
+    session.proceed( done ).ok( );
+    session_done.arrive_and_wait( );
+    if ( done )
+      break;
+    session.curr_step ++;
+    step_done.arrive_and_wait( );
+  }
+  interconnect_thread.join( );
+  interconnect.set_deferred_delivery( false ).ok( );
+  return ExitStatus::SUCCESS;
+}
+
+static ExitStatus run_windowed( Session &session, BaseInterconnect &interconnect, uint64_t max_steps ) {
+  bool done = false;
+  PacketQueue arrived; /* egressed by the interconnect, in egress_time order */
+  uint64_t it = 0;
+
+  interconnect.set_deferred_delivery( true ).ok( );
+  while ( it < max_steps ) {
+    const Step len = interconnect.window_size( Step( std::min< uint64_t >( max_steps - it, std::numeric_limits< Step >::max( ))));
+    if ( len == 0 ) {
+      interconnect.deliver( arrived, session.curr_step ).ok( );
+      session.proceed( done ).ok( );
+      if ( done )
+        break;
+      interconnect.proceed( ).ok( );
+      interconnect.collect_delivered( arrived ).ok( );
+      session.curr_step ++;
+      interconnect.curr_step ++;
+      it ++;
+      continue;
+    }
+    interconnect.proceed_window_ahead( len ).ok( );
+    interconnect.collect_delivered( arrived ).ok( );
+    for ( Step s = 0; s < len && ! done; s ++ ) {
+      interconnect.deliver( arrived, session.curr_step ).ok( );
+      session.proceed( done ).ok( );
+      if ( ! done )
+        session.curr_step ++;
+    }
+    if ( done )
+      break;
+    interconnect.proceed_window_behind( len ).ok( );
+    it += len;
+  }
+  interconnect.set_deferred_delivery( false ).ok( );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus run_simulation( Session &session,
+                           BaseInterconnect &interconnect,
+                           uint64_t max_steps,
+                           SimMode mode ) {
+  if ( mode != SimMode::SERIAL && interconnect.cnfg.interconnect_latency == 0 ) {
+    std::cerr << "Pipelined and windowed simulation need an interconnect latency of at least one step; "
+                 "running serially." << std::endl;
+    mode = SimMode::SERIAL;
+  }
+  switch ( mode ) {
+    case SimMode::PIPELINED: return run_pipelined( session, interconnect, max_steps );
+    case SimMode::WINDOWED: return run_windowed( session, interconnect, max_steps );
+    default: return run_serial( session, interconnect, max_steps );
+  }
+}
+
+SimCluster::SimCluster( DeviceId num_gpus, SimConfig &cnfg ) : cnfg( cnfg ),
+                                                               num_gpus( num_gpus ),
+                                                               ctx( ),
+                                                               gpus( new GPU[num_gpus] ),
+                                                               tm_estimator( ),
+                                                               interconnect( ) {
+  for ( DeviceId i = 0; i < num_gpus; i ++ ) {
+    gpus[ i ].cnfg = &cnfg;
+    gpus[ i ].join( ctx ).ok( );
+    gpus[ i ].setup_transport( );
+  }
+}
+
+/* the estimator the ocs and ring interconnects are configured by: the
+ * traffic the sessions will send once, or what the transports have in
+ * flight at each decision */
+static TMEstimatorBase *make_tm_estimator( DeviceId num_gpus, bool single_shot, const std::string &log_dir ) {
+  if ( single_shot )
+    return new SingleShotEsimator( num_gpus, log_dir );
+  return new TransportEstimator( num_gpus, log_dir );
+}
+
+/* binds the estimator of an ocs or ring cluster; eff_num_gpus covers every
+ * gpu the session's traffic touches, to keep the solvers small */
+static ExitStatus bind_reconfigurable( SimCluster &cluster,
+                                       Session &session,
+                                       bool single_shot,
+                                       bool log_tm,
+                                       DeviceId &eff_num_gpus ) {
+  auto transport_estimator = dynamic_cast< TransportEstimator * >( cluster.tm_estimator.get( ));
+  if ( ! single_shot )
+    transport_estimator->bind_to_transports( cluster.gpus.get( ), cluster.num_gpus );
+  cluster.tm_estimator->bind_to_sessions( &session, 1 );
+  if ( log_tm )
+    cluster.tm_estimator->log( );
+  int max_src_dst = 0;
+  for ( const auto &e : cluster.tm_estimator->tm_est ) {
+    if ( e.value > 0 )
+      max_src_dst = std::max( max_src_dst, int( std::max( e.row, e.col )));
+  }
+  eff_num_gpus = max_src_dst + 1;
+  if ( ! single_shot )
+    transport_estimator->set_eff_num_transports( eff_num_gpus );
+  return ExitStatus::SUCCESS;
+}
+
+InterconnectFactory electrical_switch_factory( double bw_per_port_bytes ) {
+  InterconnectFactory factory;
+  factory.build = [ = ]( SimCluster &cluster, const std::string &log_dir ) {
+    auto tm_estimator = new TransportEstimator( cluster.num_gpus, log_dir );
+    cluster.tm_estimator.reset( tm_estimator );
+    cluster.interconnect.reset( new ElectricalSwitch( 0 /* device_id */, cluster.gpus.get( ), cluster.num_gpus, bw_per_port_bytes, bw_per_port_bytes, tm_estimator, cluster.cnfg, bw_per_port_bytes, log_dir ));
+    return ExitStatus::SUCCESS;
+  };
+  /* the switch shares its ports by the transport traffic, and the
+   * session's traffic is only logged */
+  factory.bind = [ ]( SimCluster &cluster, Session &session, const std::string &log_dir, bool log_tm ) {
+    static_cast< TransportEstimator * >( cluster.tm_estimator.get( ))->bind_to_transports( cluster.gpus.get( ), cluster.num_gpus );
+    if ( log_tm ) {
+      SingleShotEsimator single_shot_esimator( cluster.num_gpus, log_dir );
+      single_shot_esimator.bind_to_sessions( &session, 1 );
+      single_shot_esimator.log( );
+    }
+    return ExitStatus::SUCCESS;
+  };
+  return factory;
+}
+
+InterconnectFactory fullmesh_factory( double bw_per_port_bytes ) {
+  InterconnectFactory factory;
+  factory.build = [ = ]( SimCluster &cluster, const std::string &log_dir ) {
+    auto tm_estimator = new SingleShotEsimator( cluster.num_gpus, log_dir );
+    cluster.tm_estimator.reset( tm_estimator );
+    cluster.interconnect.reset( new FullMeshInterconnect( 0 /* device_id */, cluster.gpus.get( ), cluster.num_gpus, bw_per_port_bytes, bw_per_port_bytes, tm_estimator, cluster.cnfg, log_dir ));
+    return ExitStatus::SUCCESS;
+  };
+  factory.bind = [ ]( SimCluster &cluster, Session &session, const std::string &, bool log_tm ) {
+    cluster.tm_estimator->bind_to_sessions( &session, 1 );
+    if ( log_tm )
+      cluster.tm_estimator->log( );
+    return ExitStatus::SUCCESS;
+  };
+  return factory;
+}
+
+InterconnectFactory ocs_factory( double bw_per_port_bytes, uint16_t num_ocs, uint16_t port_count, bool single_shot ) {
+  InterconnectFactory factory;
+  factory.build = [ = ]( SimCluster &cluster, const std::string &log_dir ) {
+    cluster.tm_estimator.reset( make_tm_estimator( cluster.num_gpus, single_shot, log_dir ));
+    cluster.interconnect.reset( new OCSInterconnect( 0 /* device_id */, cluster.gpus.get( ), cluster.num_gpus, bw_per_port_bytes, bw_per_port_bytes, cluster.tm_estimator.get( ), cluster.cnfg, num_ocs, port_count, single_shot, log_dir ));
+    return ExitStatus::SUCCESS;
+  };
+  factory.bind = [ = ]( SimCluster &cluster, Session &session, const std::string &, bool log_tm ) {
+    DeviceId eff_num_gpus;
+    bind_reconfigurable( cluster, session, single_shot, log_tm, eff_num_gpus ).ok( );
+    auto &ocs = static_cast< OCSInterconnect & >( *cluster.interconnect );
+    ocs.set_eff_num_gpus( eff_num_gpus ).ok( );
+    return ocs.setup_optimal_solver( );
+  };
+  return factory;
+}
+
+InterconnectFactory ring_factory( double bw_per_port_bytes,
+                                  uint16_t num_waves,
+                                  BWDecisionType bw_decision_type,
+                                  DeviceId max_dist,
+                                  bool single_shot ) {
+  InterconnectFactory factory;
+  factory.build = [ = ]( SimCluster &cluster, const std::string &log_dir ) {
+    cluster.tm_estimator.reset( make_tm_estimator( cluster.num_gpus, single_shot, log_dir ));
+    cluster.interconnect.reset( new RingInterconnect( 0 /* device_id */, cluster.gpus.get( ), cluster.num_gpus, bw_per_port_bytes, bw_per_port_bytes, cluster.tm_estimator.get( ), cluster.cnfg, num_waves, bw_decision_type, max_dist, 5 /* num_rings */, log_dir ));
+    return ExitStatus::SUCCESS;
+  };
+  factory.bind = [ = ]( SimCluster &cluster, Session &session, const std::string &, bool log_tm ) -> ExitStatus {
+    DeviceId eff_num_gpus;
+    bind_reconfigurable( cluster, session, single_shot, log_tm, eff_num_gpus ).ok( );
+    auto &ring = static_cast< RingInterconnect & >( *cluster.interconnect );
+    ring.set_eff_num_gpus( eff_num_gpus ).ok( );
+    if ( bw_decision_type == BWDecisionType::ILP )
+      return ring.setup_ilp_solver( );
+    return ExitStatus::SUCCESS;
+  };
+  return factory;
+}
+
+ExitStatus simulate_graph( SimCluster &cluster,
+                           const InterconnectFactory &factory,
+                           CG &graph,
+                           uint64_t max_steps,
+                           SimMode mode,
+                           const std::string &log_dir,
+                           bool log_tm,
+                           Step &num_steps ) {
+  Session session( 0 /* session_id */, cluster.gpus.get( ), graph, log_dir );
+  factory.bind( cluster, session, log_dir, log_tm ).ok( );
+  run_simulation( session, *cluster.interconnect, max_steps, mode ).ok( );
+  num_steps = session.curr_step;
+  if ( max_steps > 0 && session.has_finished_pass )
+    return ExitStatus::SUCCESS;
+  return ExitStatus::NOT_AVAILABLE;
+}
+
+ExitStatus simulate_copy( const CG &graph,
+                          DeviceId num_gpus,
+                          SimConfig &cnfg,
+                          const InterconnectFactory &factory,
+                          uint64_t max_steps,
+                          SimMode mode,
+                          const std::string &log_dir,
+                          Step &num_steps ) {
+  SimCluster cluster( num_gpus, cnfg );
+  factory.build( cluster, log_dir ).ok( );
+  CG copy;
+  graph.clone( copy ).ok( );
+  copy.remap_devices( [ & ]( Device *device ) -> Device * {
+    if ( device->type == DeviceType::GPU )
+      return &cluster.gpus[ device->dev_id ];
+    if ( device->type == DeviceType::INTERCONNECT )
+      return cluster.interconnect.get( );
+    return device;
+  } ).ok( );
+  const ExitStatus status = simulate_graph( cluster, factory, copy, max_steps, mode, log_dir, false, num_steps );
+  copy.release_ops( ).ok( );
+  return status;
+}
@@ -0,0 +1,114 @@
+#ifndef ROSTAM_SRC_INTERCONNECT_SIMULATION_HH_
+#define ROSTAM_SRC_INTERCONNECT_SIMULATION_HH_
+#include <functional>
+#include <memory>
+#include <string>
+#include "base_interconnect.hh"
+#include "tm_estimator.hh"
+#include "ring.hh"
+#include "gpu.hh"
+#include "sim_context.hh"
+#include "session.hh"
+
+enum class SimMode {
+  SERIAL,
+  PIPELINED,
+  WINDOWED
+};
+
+/* Advance session and interconnect until the session finishes a pass or
+ * max_steps steps have run. Session and interconnect keep their own clocks
+ * ( curr_step ), which the driver advances.
+ *
+ * SERIAL steps both one after the other.
+ *
+ * PIPELINED runs the interconnect on its own thread: while the session
+ * launches the ops of step t, the interconnect ingests its backlog and
+ * routes and egresses the packets of step t, then ingests what the session
+ * sent once both meet at a barrier. Packets delivered in step t are handed
+ * to their gpus by the session thread at the start of step t + 1, so both
+ * threads only ever touch their own state between barriers.
+ *
+ * WINDOWED is a conservative parallel simulation: between episode starts,
+ * time is cut into windows of up to interconnect_latency steps, in which
+ * nothing the sessions send can reach another gpu. The interconnect runs
+ * each window ahead, its gpu partitions advancing independently on the
+ * interconnect's worker threads ( see set_num_threads( )); the session then
+ * runs the whole window against the packets delivered in it, and the
+ * interconnect takes in what was sent. The logical processes only
+ * synchronize at window boundaries, and episode starts are stepped in lock
+ * step.
+ *
+ * All modes give the same simulated timeline. The others need an
+ * interconnect_latency of at least one step (packets sent in step t can't
+ * be routed before step t + 1); otherwise the serial loop is used. */
+ExitStatus run_simulation( Session &session,
+                           BaseInterconnect &interconnect,
+                           uint64_t max_steps,
+                           SimMode mode );
+
+/* gpus of its own, in their own simulation, and the traffic matrix
+ * estimator and interconnect an InterconnectFactory builds on them */
+struct SimCluster {
+  SimConfig &cnfg;
+  const DeviceId num_gpus;
+  SimContext ctx;
+  std::unique_ptr< GPU[] > gpus;
+  std::unique_ptr< TMEstimatorBase > tm_estimator;
+  std::unique_ptr< BaseInterconnect > interconnect;
+
+  SimCluster( DeviceId num_gpus, SimConfig &cnfg );
+
+  SimCluster( const SimCluster & ) = delete;
+
+  SimCluster &operator=( const SimCluster & ) = delete;
+};
+
+/* how one topology is set up on a cluster, as the sipml-* binaries do it */
+struct InterconnectFactory {
+  /* sets the cluster's tm_estimator and interconnect */
+  std::function< ExitStatus( SimCluster &cluster, const std::string &log_dir ) > build { };
+  /* binds the estimator once session runs on the cluster and readies the
+   * interconnect for its traffic; with log_tm, logs that traffic matrix to
+   * log_dir */
+  std::function< ExitStatus( SimCluster &cluster, Session &session, const std::string &log_dir, bool log_tm ) > bind { };
+};
+
+InterconnectFactory electrical_switch_factory( double bw_per_port_bytes );
+
+InterconnectFactory fullmesh_factory( double bw_per_port_bytes );
+
+InterconnectFactory ocs_factory( double bw_per_port_bytes, uint16_t num_ocs, uint16_t port_count, bool single_shot );
+
+InterconnectFactory ring_factory( double bw_per_port_bytes,
+                                  uint16_t num_waves,
+                                  BWDecisionType bw_decision_type,
+                                  DeviceId max_dist,
+                                  bool single_shot );
+
+/* Run graph, placed on the cluster's gpus and interconnect, as a session of
+ * its own until it finishes a pass or max_steps steps have run. num_steps
+ * is the step the session stopped at; NOT_AVAILABLE if the pass didn't
+ * finish. */
+ExitStatus simulate_graph( SimCluster &cluster,
+                           const InterconnectFactory &factory,
+                           CG &graph,
+                           uint64_t max_steps,
+                           SimMode mode,
+                           const std::string &log_dir,
+                           bool log_tm,
+                           Step &num_steps );
+
+/* simulate_graph( ) on a copy of graph, moved to a fresh cluster of
+ * num_gpus gpus that factory builds, so graph and the cluster it was placed
+ * on are left as they were */
+ExitStatus simulate_copy( const CG &graph,
+                          DeviceId num_gpus,
+                          SimConfig &cnfg,
+                          const InterconnectFactory &factory,
+                          uint64_t max_steps,
+                          SimMode mode,
+                          const std::string &log_dir,
+                          Step &num_steps );
+
+#endif //ROSTAM_SRC_INTERCONNECT_SIMULATION_HH_
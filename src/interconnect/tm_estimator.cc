@@ -28,31 +28,38 @@ void TMEstimatorBase::log( ) {
 }
 
 ExitStatus TransportEstimator::update_tm_est( ) {
-  Matrix2D< double > temp_tm( num_transports, num_transports );
-  Matrix2D< double > last_episode_tm( num_transports, num_transports );
-
-  for ( int tp_no = 0; tp_no < num_transports; tp_no ++ ) {
-    transports[ tp_no ]->get_tm_estimate( temp_tm ); //todo: make this more efficient by seperating into sent & recv bytes
-    last_episode_tm.add_by( temp_tm );
+  /* the transports keep inflight_tm current, so an update only copies
+   * the active pairs among the effective transports */
+  tm_est.fill_zeros( );
+  for ( const auto &e : inflight_tm ) {
+    if ( int( e.row ) < num_transports && int( e.col ) < num_transports )
+      tm_est.set_elem( e.row, e.col, e.value );
   }
-  tm_est.copy_from( last_episode_tm );
+  return ExitStatus::SUCCESS;
+}
 
-//  for ( int i = 0; i < 8; i ++ ){
-//    for (int j =0; j < 8; j++ )
-//      std::cout << tm_est.get_elem(i, j) << " ";
-//    std::cout << std::endl;
-//  }
-//  std::cout << "------------------------------" << std::endl;
+ExitStatus TransportEstimator::snapshot( SparseMatrix2D< double > &tm ) const {
+  tm.copy_from( inflight_tm );
+  return ExitStatus::SUCCESS;
+}
 
+ExitStatus TransportEstimator::delta( SparseMatrix2D< double > &tm ) const {
+  tm.copy_from( inflight_tm );
+  tm.sub_by( tm_est );
   return ExitStatus::SUCCESS;
 }
 
 ExitStatus TransportEstimator::bind_to_transports( GPU *gpus, int num_gpus ) {
   num_transports = num_gpus;
+  SparseMatrix2D< double > temp_tm( num_gpus, num_gpus );
+  inflight_tm.fill_zeros( );
   for ( int gpu_no = 0; gpu_no < num_gpus; gpu_no ++ ) {
     transports[ gpu_no ] = gpus[ gpu_no ].tp;
+    /* account for anything already in flight, then follow the updates */
+    transports[ gpu_no ]->get_tm_estimate( temp_tm ).ok( );
+    inflight_tm.add_by( temp_tm );
+    transports[ gpu_no ]->bind_global_tm( &inflight_tm ).ok( );
   }
-//  update_tm_est( );
   return ExitStatus::SUCCESS;
 }
 
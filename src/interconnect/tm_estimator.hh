@@ -2,11 +2,12 @@
 #define SIPML_SRC_TM_ESTIMATOR_HH_
 #include <cstdint>
 #include "sim_config.hh"
+#include "sparse_matrix.hh"
 #include "session.hh"
 
 class TMEstimatorBase {
  public:
-  Matrix2D< double > tm_est;
+  SparseMatrix2D< double > tm_est;
   const int num_gpus;
   Session *sessions;
   int num_sessions;
@@ -52,14 +53,23 @@ class SingleShotEsimator : public TMEstimatorBase {
 class TransportEstimator : public TMEstimatorBase {
   Transport **transports;
   int num_transports;
+  /* bytes sent but not yet received for each gpu pair; kept up to date
+   * by the bound transports on every send/recv */
+  SparseMatrix2D< double > inflight_tm;
  public:
   TransportEstimator( const int num_gpus, const std::string &log_dir ) : TMEstimatorBase(
-      num_gpus, log_dir ), transports( nullptr ), num_transports( -1 ) {
+      num_gpus, log_dir ), transports( nullptr ), num_transports( -1 ), inflight_tm( num_gpus, num_gpus ) {
     transports = new Transport *[num_gpus];
   }
 
   ExitStatus update_tm_est( ) override;
 
+  /* copy of the current in-flight traffic matrix, O(#active pairs) */
+  ExitStatus snapshot( SparseMatrix2D< double > &tm ) const;
+
+  /* change of the in-flight traffic matrix since the last update_tm_est( ) */
+  ExitStatus delta( SparseMatrix2D< double > &tm ) const;
+
   ExitStatus set_eff_num_transports( int n );
 
   ExitStatus bind_to_transports( GPU *gpus, int num_gpus );
@@ -3,30 +3,51 @@
 #include "gpu.hh"
 
 ExitStatus Transport::send( PacketId &last_pkt_id ) {
-  while ( ! tp_input.empty( )) {
-    Packet *p = tp_input.front( );
-    flying_pkts.emplace( p->pkt_id, p );
-    tm_est.add_elem_by( p->src->dev_id, p->dst->dev_id, p->num_bytes );
-    tx_buff.push_back( p );
-    last_pkt_id = p->pkt_id;
-    tp_input.pop_front( );
+  if ( tp_input.empty( ))
+    return ExitStatus::SUCCESS;
+  for ( Packet *p : tp_input ) {
+    ctx.flying_pkts.emplace( p->pkt_id, p );
+    assert( p->src->dev_id == dev_id );
+    inflight_bytes[ p->dst->dev_id ] += p->num_bytes;
+    if ( global_tm != nullptr )
+      global_tm->add_elem_by( p->src->dev_id, p->dst->dev_id, p->num_bytes );
+  }
+  last_pkt_id = tp_input.back( )->pkt_id;
+  tx_buff.splice_back( tp_input );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Transport::get_tm_estimate( SparseMatrix2D< double > &tm ) const {
+  tm.fill_zeros( );
+  for ( const auto &d : inflight_bytes ) {
+    if ( dev_id < tm.get_n_rows( ) && d.first < tm.get_n_cols( ))
+      tm.set_elem( dev_id, d.first, d.second );
   }
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus Transport::get_tm_estimate( Matrix2D< double > &tm ) {
-  tm.copy_from( tm_est );
+ExitStatus Transport::bind_global_tm( SparseMatrix2D< double > *tm ) {
+  global_tm = tm;
   return ExitStatus::SUCCESS;
 }
 
 ExitStatus Transport::recv( Packet *pkt ) {
-  if ( flying_pkts.erase( pkt->pkt_id ) == 1 ) {
+  if ( ctx.flying_pkts.erase( pkt->pkt_id ) == 1 ) {
     pkt->acked = true;
-    tm_est.sub_elem_by( pkt->src->dev_id, pkt->dst->dev_id, pkt->num_bytes );
-    if ( GPU::recv_sig.count( pkt->pkt_id ) == 1 ) {
-      GPU::recv_sig.at( pkt->pkt_id )->end = Device::curr_step;
-      GPU::recv_sig.at( pkt->pkt_id )->status = OpStatus::FINISHED;
-      GPU::recv_sig.erase( pkt->pkt_id );
+    /* the bytes are accounted at the sender's transport */
+    Transport *src_tp = static_cast< const GPU * >( pkt->src )->tp;
+    auto it = src_tp->inflight_bytes.find( pkt->dst->dev_id );
+    it->second -= pkt->num_bytes;
+    if ( it->second == 0 )
+      src_tp->inflight_bytes.erase( it );
+    if ( global_tm != nullptr )
+      global_tm->sub_elem_by( pkt->src->dev_id, pkt->dst->dev_id, pkt->num_bytes );
+    auto sig = ctx.recv_sig.find( pkt->pkt_id );
+    if ( sig != ctx.recv_sig.end( )) {
+      /* delivery can be deferred past the step the packet arrived in */
+      sig->second->end = pkt->rx_time;
+      sig->second->status = OpStatus::FINISHED;
+      ctx.recv_sig.erase( sig );
     }
     /* we don't need this packet any more :D */
     delete pkt;
@@ -1,37 +1,51 @@
 #ifndef SIPML_SRC_TRANSPORT_HH_
 #define SIPML_SRC_TRANSPORT_HH_
 #include <unordered_map>
-#include <deque>
-#include "packet.hh"
+#include "packet_queue.hh"
 #include "exit_status.hh"
 #include "op.hh"
-#include "matrix.hh"
-
-using PacketQueue = std::deque< Packet * >;
+#include "sparse_matrix.hh"
+#include "sim_context.hh"
 
 class Transport {
  private:
-  /* currently assume all packets acks are shared centeralized */
-  static std::unordered_map< PacketId, Packet * > flying_pkts;
+  /* the simulation this transport belongs to; holds the in-flight packets
+   * and the recv signals */
+  SimContext &ctx;
  public:
   /* couple to each device */
   PacketQueue &tx_buff;
   PacketQueue &rx_buff;
   PacketQueue tp_input;
  private:
-  Matrix2D< double > tm_est;
+  /* id of the device this transport sends from */
+  const DeviceId dev_id;
+  /* bytes sent to each destination but not yet received there; only
+   * destinations with outstanding bytes are stored */
+  std::unordered_map< DeviceId, double > inflight_bytes;
+  /* a global in-flight traffic matrix shared by all transports ( owned by
+   * the tm estimator ); updated in O(1) on every send and recv */
+  SparseMatrix2D< double > *global_tm;
  public:
-  Transport( std::deque< Packet * > &tx_buff,
-             std::deque< Packet * > &rx_buff,
-             const int num_gpus )
-      : tx_buff( tx_buff ), rx_buff( rx_buff ), tp_input( ), tm_est( num_gpus, num_gpus ) {
+  Transport( SimContext &ctx,
+             const DeviceId dev_id,
+             PacketQueue &tx_buff,
+             PacketQueue &rx_buff )
+      : ctx( ctx ), tx_buff( tx_buff ), rx_buff( rx_buff ), tp_input( ), dev_id( dev_id ), inflight_bytes( ), global_tm( nullptr ) {
   }
 
+  Transport( const Transport & ) = delete;
+
+  Transport &operator=( const Transport & ) = delete;
+
   ExitStatus recv( Packet *pkt );
 
   ExitStatus send( PacketId &last_pkt_id );
 
-  ExitStatus get_tm_estimate( Matrix2D< double > &tm );
+  /* this transport's row of the traffic matrix */
+  ExitStatus get_tm_estimate( SparseMatrix2D< double > &tm ) const;
+
+  ExitStatus bind_global_tm( SparseMatrix2D< double > *tm );
 };
 
 #endif //SIPML_SRC_TRANSPORT_HH_
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <limits>
+#include "avail_tree.hh"
+
+using namespace std;
+
+constexpr size_t AvailTree::none;
+
+bool AvailTree::earlier( const size_t a, const size_t b ) const {
+  if ( b == none )
+    return a != none;
+  if ( a == none )
+    return false;
+  return avail_time[ a ] < avail_time[ b ] || ( avail_time[ a ] == avail_time[ b ] && a < b );
+}
+
+void AvailTree::pull( const size_t node ) {
+  const size_t left = 2 * node;
+  const size_t right = 2 * node + 1;
+  earliest_id[ node ] = ( earlier( earliest_id[ right ], earliest_id[ left ] ) ? earliest_id[ right ] : earliest_id[ left ] );
+  max_free[ node ] = max( max_free[ left ], max_free[ right ] );
+  min_free[ node ] = min( min_free[ left ], min_free[ right ] );
+}
+
+ExitStatus AvailTree::reset( const vector< Step > &gpu_avail_time, const vector< uint64_t > &gpu_free_mem ) {
+  if ( gpu_avail_time.size( ) != gpu_free_mem.size( ))
+    return ExitStatus::FAILURE;
+  num_leaves = gpu_avail_time.size( );
+  base = 1;
+  while ( base < num_leaves )
+    base <<= 1;
+  avail_time = gpu_avail_time;
+  free_mem = gpu_free_mem;
+  /* the padding leaves have no memory, so they are never picked */
+  earliest_id.assign( 2 * base, none );
+  max_free.assign( 2 * base, 0 );
+  min_free.assign( 2 * base, 0 );
+  for ( size_t id = 0; id < num_leaves; id ++ ) {
+    earliest_id[ base + id ] = id;
+    max_free[ base + id ] = free_mem[ id ];
+    min_free[ base + id ] = free_mem[ id ];
+  }
+  for ( size_t node = base - 1; node > 0; node -- )
+    pull( node );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus AvailTree::update( const size_t id, const Step gpu_avail_time, const uint64_t gpu_free_mem ) {
+  if ( id >= num_leaves )
+    return ExitStatus::FAILURE;
+  avail_time[ id ] = gpu_avail_time;
+  free_mem[ id ] = gpu_free_mem;
+  size_t node = base + id;
+  max_free[ node ] = gpu_free_mem;
+  min_free[ node ] = gpu_free_mem;
+  for ( node /= 2; node > 0; node /= 2 )
+    pull( node );
+  return ExitStatus::SUCCESS;
+}
+
+size_t AvailTree::query( const size_t node,
+                         const size_t node_lo,
+                         const size_t node_hi,
+                         const size_t lo,
+                         const size_t hi,
+                         const uint64_t mem_size ) const {
+  if ( hi <= node_lo || node_hi <= lo || max_free[ node ] <= mem_size )
+    return none;
+  if ( lo <= node_lo && node_hi <= hi && min_free[ node ] > mem_size )
+    return earliest_id[ node ];
+  /* a leaf has min_free == max_free, so it never gets here */
+  const size_t mid = node_lo + ( node_hi - node_lo ) / 2;
+  const size_t left = query( 2 * node, node_lo, mid, lo, hi, mem_size );
+  const size_t right = query( 2 * node + 1, mid, node_hi, lo, hi, mem_size );
+  return ( earlier( right, left ) ? right : left );
+}
+
+ExitStatus AvailTree::earliest( const size_t lo, const size_t hi, const uint64_t mem_size, size_t &id ) const {
+  id = ( lo < hi && hi <= num_leaves ? query( 1, 0, base, lo, hi, mem_size ) : none );
+  return ( id == none ? ExitStatus::NOT_AVAILABLE : ExitStatus::SUCCESS );
+}
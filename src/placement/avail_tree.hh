@@ -0,0 +1,48 @@
+#ifndef SIPML_SRC_PLACEMENT_AVAIL_TREE_HH_
+#define SIPML_SRC_PLACEMENT_AVAIL_TREE_HH_
+#include <cstdint>
+#include <vector>
+#include "exit_status.hh"
+#include "sim_config.hh"
+
+/* a segment tree over the gpus of a ring, by the step each one is next
+ * available at and the memory it has left. Finding the earliest gpu of a
+ * range with enough memory skips the subtrees where none, or all, of the
+ * gpus have enough, so it takes O( log n ) unless memory is nearly full */
+class AvailTree {
+ private:
+  size_t num_leaves;
+  size_t base; /* first leaf node, a power of two */
+  std::vector< Step > avail_time;
+  std::vector< uint64_t > free_mem;
+  /* per node: the earliest gpu below it, the lowest on ties, and the most
+   * and least memory left on any gpu below it */
+  std::vector< size_t > earliest_id;
+  std::vector< uint64_t > max_free;
+  std::vector< uint64_t > min_free;
+
+  bool earlier( size_t a, size_t b ) const;
+
+  void pull( size_t node );
+
+  size_t query( size_t node, size_t node_lo, size_t node_hi, size_t lo, size_t hi, uint64_t mem_size ) const;
+
+ public:
+  static constexpr size_t none = SIZE_MAX;
+
+  AvailTree( ) : num_leaves( 0 ), base( 1 ), avail_time( ), free_mem( ), earliest_id( ), max_free( ), min_free( ) { }
+
+  ExitStatus reset( const std::vector< Step > &gpu_avail_time, const std::vector< uint64_t > &gpu_free_mem );
+
+  ExitStatus update( size_t id, Step gpu_avail_time, uint64_t gpu_free_mem );
+
+  /* the earliest available gpu in [ lo, hi ) with more than mem_size
+   * bytes left, the lowest one on ties; NOT_AVAILABLE if there is none */
+  ExitStatus earliest( size_t lo, size_t hi, uint64_t mem_size, size_t &id ) const;
+
+  size_t size( ) const { return num_leaves; }
+
+  Step time( size_t id ) const { return avail_time.at( id ); }
+};
+
+#endif //SIPML_SRC_PLACEMENT_AVAIL_TREE_HH_
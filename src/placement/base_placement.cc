@@ -1,4 +1,8 @@
 #include "base_placement.hh"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <unordered_set>
 
 void device_utilization_stats( std::map< Device*, Step > load_dist_map, Step num_steps_est, bool verbose ){
   if (verbose){
@@ -31,24 +35,9 @@ void device_utilization_stats( std::map< Device*, Step > load_dist_map, Step num
 }
 ExitStatus BasePlacement::estimate_iter_time( CG &graph, Step &num_steps_est ) {
   /* get the bandwidth estimates */
-  std::unordered_map< Device *, std::unordered_map< Device *, double>> bw_est;
+  BWEstimate bw_est;
   interconnect->offline_bw_est( bw_est ); /* bw_est will be in bytes per step */
-
-  /* traverse the compute graph to find the total time */
-  num_steps_est = 0;
-  std::unordered_map< Device *, Step > comp_avail_time;
-  std::unordered_map< Device *, Step > net_avail_time_tx;
-  std::unordered_map< Device *, Step > net_avail_time_rx;
-
-  std::map< uint32_t, Op * > run_order;
-  graph.priority_sort( run_order );
-  assert( graph.adj.size( ) == run_order.size( ));
-  double comm_time = 0;
-  Step path_avail_time;
-
-  int n_netop = 0;
-  uint32_t prior = 0;
-  size_t count = 0;
+  estimate_iter_time( graph, bw_est, num_steps_est ).ok( );
 
   /* some informative stats */
   uint64_t total_xfer_bytes = 0;
@@ -58,84 +47,236 @@ ExitStatus BasePlacement::estimate_iter_time( CG &graph, Step &num_steps_est ) {
   graph.critical_path_load( critical_path_load );
   graph.critical_path_len( critical_path_len );
   std::map< Device*, Step > load_dist_map;
+  for ( auto e : graph.adj ) {
+    Op *op = e.first;
+    if ( op->type == OpType::NETWORK ) {
+      total_xfer_bytes += static_cast<NetOp *>( op )->transfer_bytes;
+    } else if ( op->type == OpType::COMPUTE ) {
+      auto comp_time = static_cast<CompOp *>( op )->comp_time;
+      if ( op->device->type == DeviceType::GPU )
+        comp_time =
+            ( comp_time < interconnect->cnfg.gpu_min_comp_time ? interconnect->cnfg.gpu_min_comp_time : comp_time );
+      total_comp_load += comp_time;
+      load_dist_map[ op->device ] += comp_time;
+    }
+  }
+  std::cout << "total_xfer_bytes="    << total_xfer_bytes   * 1e-9 << "GB, "
+            << "total_comp_load="     << total_comp_load    * 1e-3 << "ms, "
+            << "critical_path_load="  << critical_path_load * 1e-3 << "ms, "
+            << "critical_path_len="   << critical_path_len         << "."
+            << std::endl;
+  device_utilization_stats( load_dist_map, num_steps_est, false );
+  return ExitStatus::SUCCESS;
+}
 
-  while ( count < run_order.size( )) {
-    if ( run_order.count( prior ) == 0 ) {
-      prior ++;
-      continue;
+/* the step at which a transfer starting at start has had num_steps steps
+ * of service, skipping the first reconf_delay steps of every
+ * dec_interval + reconf_delay, in which the interconnect carries nothing */
+static Step transfer_end( Step start, double num_steps, const SimConfig &cnfg ) {
+  const uint64_t max_step = std::numeric_limits< Step >::max( );
+  if ( num_steps >= double( max_step ))
+    return Step( max_step );
+  const uint64_t reconf = cnfg.interconnect_reconf_delay;
+  const uint64_t period = uint64_t( cnfg.dec_interval ) + reconf;
+  uint64_t t = start;
+  uint64_t left = uint64_t( std::ceil( num_steps ));
+  if ( reconf > 0 && left > 0 ) {
+    uint64_t phase = t % period;
+    if ( phase < reconf ) {
+      t += reconf - phase;
+      phase = reconf;
     }
-    count ++;
-    Op *op = run_order.at( prior );
-//    std::cout << op->name << std::endl;
-    prior ++;
-    /* find when input dependencies are met */
-    Step cand_start = 0;
-    op->start = std::numeric_limits< Step >::max( );
-    op->end = std::numeric_limits< Step >::max( );
-    for ( auto pred : graph.reverse_adj.at( op ))
-      cand_start = ( cand_start > pred->end ? cand_start : pred->end );
+    if ( left > period - phase ) {
+      left -= period - phase;
+      t += period - phase;
+      /* t starts a period; skip the whole periods, then finish in the last one */
+      const uint64_t active = period - reconf;
+      const uint64_t whole = ( left - 1 ) / active;
+      t += whole * period + reconf;
+      left -= whole * active;
+    }
+  }
+  return Step( std::min( t + left, max_step ));
+}
+
+ExitStatus BasePlacement::estimate_iter_time( const CG &graph, const BWEstimate &bw_est, Step &num_steps_est ) const {
+  const SimConfig &cnfg = interconnect->cnfg;
+  double tx_bw, rx_bw;
+  interconnect->offline_port_bw_est( tx_bw, rx_bw ).ok( );
+  tx_bw *= calibration.bw_efficiency;
+  rx_bw *= calibration.bw_efficiency;
+  const uint64_t net_overhead = uint64_t( calibration.net_overhead_sec / cnfg.step_size_sec + 0.5 );
+
+  /* when each resource is free next */
+  std::vector< Step > comp_avail_time( num_gpus, 0 );
+  std::vector< Step > tx_avail_time( num_gpus, 0 );
+  std::vector< Step > rx_avail_time( num_gpus, 0 );
+  std::unordered_map< uint64_t, Step > pair_avail_time;
+
+  /* ops are ranked by priority, and by creation among equal priorities,
+   * with a counting sort; graph.adj is already in creation order */
+  const size_t num_ops = graph.adj.size( );
+  uint32_t max_priority = 0;
+  for ( const auto &e : graph.adj )
+    max_priority = std::max( max_priority, e.first->priority );
+  std::vector< Op * > ranked( num_ops );
+  if ( max_priority < 2 * num_ops ) {
+    std::vector< size_t > bucket_end( size_t( max_priority ) + 2, 0 );
+    for ( const auto &e : graph.adj )
+      bucket_end[ e.first->priority + 1 ] ++;
+    for ( size_t p = 1; p < bucket_end.size( ); p ++ )
+      bucket_end[ p ] += bucket_end[ p - 1 ];
+    for ( const auto &e : graph.adj )
+      ranked[ bucket_end[ e.first->priority ] ++ ] = e.first;
+  } else {
+    /* sparse priorities, not from fix_priorities( ) */
+    size_t i = 0;
+    for ( const auto &e : graph.adj )
+      ranked[ i ++ ] = e.first;
+    std::stable_sort( ranked.begin( ), ranked.end( ), []( const Op *a, const Op *b ) {
+      return a->priority < b->priority;
+    } );
+  }
+
+  /* walk the ranks and schedule each op whose inputs are done. An op that
+   * is not, because its priority is lower than one of its inputs', e.g. a
+   * sync op added after fix_priorities( ), goes as soon as its last input
+   * does, as a priority queue of the ready ops would take it then. op->start
+   * holds the time the last input finished until the op is scheduled.
+   * O( V + E ) */
+  std::unordered_map< Op *, size_t > num_waiting;
+  num_waiting.reserve( num_ops );
+  for ( const auto &e : graph.reverse_adj ) {
+    e.first->start = 0;
+    num_waiting[ e.first ] = e.second.size( );
+  }
+  std::unordered_set< Op * > passed;
+  passed.reserve( num_ops );
+  std::vector< Op * > overdue; /* passed ops whose inputs just finished */
 
-    /* handle operation time of each op node */
+  num_steps_est = 0;
+  size_t rank = 0;
+  while ( rank < num_ops || ! overdue.empty( )) {
+    Op *op;
+    if ( ! overdue.empty( )) {
+      op = overdue.back( );
+      overdue.pop_back( );
+    } else {
+      op = ranked[ rank ++ ];
+      if ( num_waiting.at( op ) > 0 ) {
+        passed.insert( op );
+        continue;
+      }
+    }
+    const Step cand_start = op->start;
     if ( op->type == OpType::NETWORK ) {
-      n_netop ++;
-      auto *net_op = dynamic_cast<NetOp *>( op );
-      if ( net_avail_time_tx.count( net_op->src_device ) == 0 )
-        net_avail_time_tx[ net_op->src_device ] = 0;
-      if ( net_avail_time_rx.count( net_op->dst_device ) == 0 )
-        net_avail_time_rx[ net_op->dst_device ] = 0;
-      path_avail_time = net_avail_time_tx.at( net_op->src_device ) > net_avail_time_rx.at( net_op->dst_device ) ?
-          net_avail_time_tx.at( net_op->src_device ) : net_avail_time_rx.at( net_op->dst_device );
-      op->start = ( cand_start > path_avail_time ? cand_start : path_avail_time );
-      double out_degree = graph.adj.at( op ).size( );
-      comm_time = net_op->transfer_bytes / bw_est[ net_op->src_device ][ net_op->dst_device ] * out_degree;
-//      std::cout << net_op->transfer_bytes << " "
-//                << bw_est[ net_op->src_device ][ net_op->dst_device ] << std::endl;
-      comm_time =
-          ( comm_time < interconnect->cnfg.interconnect_latency ? interconnect->cnfg.interconnect_latency : comm_time );
-//      comm_time = comm_time < 10 ? 10 : comm_time; //todo: double check this
-      op->end = op->start + Step( comm_time );
-      total_xfer_bytes += net_op->transfer_bytes;
-      net_avail_time_tx.at( net_op->src_device ) = op->end;
-      net_avail_time_rx.at( net_op->dst_device ) = 0;//op->end;
-    } else if ( op->type == OpType::MEMORY ) {
-      op->start = cand_start;
-      op->end = op->start;
+      auto *net_op = static_cast<NetOp *>( op );
+      const DeviceId src = net_op->src_device->dev_id;
+      const DeviceId dst = net_op->dst_device->dev_id;
+      const double bytes = net_op->transfer_bytes;
+      Step &pair_avail = pair_avail_time[ ( uint64_t( src ) << 32 ) | dst ];
+      op->start = std::max( { cand_start, pair_avail, tx_avail_time[ src ], rx_avail_time[ dst ] } );
+      /* the transfer goes out in packets: it is served at the slowest of its
+       * pair and ports and pays the latency once, on its last packet, while
+       * its ports are only held for their own share of the bytes */
+      const double bw = std::min( { bw_est.at( net_op->src_device ).at( net_op->dst_device ) * calibration.bw_efficiency,
+                                    tx_bw,
+                                    rx_bw } );
+      pair_avail = transfer_end( op->start, bytes / bw, cnfg );
+      tx_avail_time[ src ] = transfer_end( op->start, bytes / tx_bw, cnfg );
+      rx_avail_time[ dst ] = transfer_end( op->start, bytes / rx_bw, cnfg );
+      op->end = Step( std::min< uint64_t >( uint64_t( pair_avail ) + cnfg.interconnect_latency + net_overhead,
+                                            std::numeric_limits< Step >::max( )));
     } else if ( op->type == OpType::COMPUTE && op->device->type == DeviceType::GPU ) {
-      if ( comp_avail_time.count( op->device ) == 0 )
-        comp_avail_time.emplace( op->device, 0 );
-      auto *comp_op = dynamic_cast<CompOp *>( op );
-      comp_op->start =
-          ( cand_start > comp_avail_time.at( comp_op->device ) ? cand_start : comp_avail_time.at( comp_op->device ));
+      auto *comp_op = static_cast<CompOp *>( op );
+      Step &comp_avail = comp_avail_time[ op->device->dev_id ];
+      op->start = std::max( cand_start, comp_avail );
       auto comp_time = comp_op->comp_time;
-      comp_time =
-          ( comp_time < interconnect->cnfg.gpu_min_comp_time ? interconnect->cnfg.gpu_min_comp_time : comp_time );
-      comp_op->end = comp_op->start + comp_time + interconnect->cnfg.gpu_launch_latency;
-      comp_avail_time.at( op->device ) = comp_op->end;
-      total_comp_load += comp_time;
-      load_dist_map[ op->device ] += comp_time;
-    } else if ( op->type == OpType::COMPUTE && op->device->type == DeviceType::CPU ) {
-      auto *comp_op = dynamic_cast<CompOp *>( op );
+      comp_time = ( comp_time < cnfg.gpu_min_comp_time ? cnfg.gpu_min_comp_time : comp_time );
+      op->end = op->start + comp_time + cnfg.gpu_launch_latency;
+      comp_avail = op->end;
+    } else if ( op->type == OpType::COMPUTE ) {
       /* presume there are abundant cpu cores;
        * otherwise should a cpu available similar to gpus */
-      comp_op->start = cand_start;
-      comp_op->end = comp_op->start + comp_op->comp_time;
-      total_comp_load += comp_op->comp_time;
-      load_dist_map[ comp_op->device ] += comp_op->comp_time;
-    } else if ( op->type == OpType::CONTROL_DEPENDENCY ) {
+      op->start = cand_start;
+      op->end = op->start + static_cast<CompOp *>( op )->comp_time;
+    } else {
+      /* memory and control ops take no time */
       op->start = cand_start;
       op->end = op->start;
     }
     /* num_steps_est equals the latest op finishing time in the graph */
     num_steps_est = ( num_steps_est > op->end ? num_steps_est : op->end );
+    /* the last of them first, as they were added */
+    const size_t num_overdue = overdue.size( );
+    for ( auto succ : graph.adj.at( op )) {
+      succ->start = ( succ->start > op->end ? succ->start : op->end );
+      if ( -- num_waiting.at( succ ) == 0 && passed.count( succ ) == 1 )
+        overdue.push_back( succ );
+    }
+    std::reverse( overdue.begin( ) + num_overdue, overdue.end( ));
   }
-  std::cout << "total_xfer_bytes="    << total_xfer_bytes   * 1e-9 << "GB, "
-            << "total_comp_load="     << total_comp_load    * 1e-3 << "ms, "
-            << "critical_path_load="  << critical_path_load * 1e-3 << "ms, "
-            << "critical_path_len="   << critical_path_len         << "."
-            << std::endl;
-  device_utilization_stats( load_dist_map, num_steps_est, false );
+  return ExitStatus::SUCCESS;
+}
 
+ExitStatus BasePlacement::fix_priorities( CG &output_graph, const OpMap< std::vector< Op * > > &replicas ) {
+  /* the replicas in the order they were placed, each right after the ops
+   * it waits for, so the network ops added since come in front of the
+   * replica they feed. Replicas without inputs are left for their first
+   * consumer to pull in. O( V + E ) */
+  std::vector< Op * > placed_order;
+  for ( auto &p : replicas ) {
+    for ( auto op : p.second ) {
+      if ( op->priority >= placed_order.size( ))
+        placed_order.resize( op->priority + 1, nullptr );
+      placed_order[ op->priority ] = op;
+    }
+  }
+  std::unordered_set< Op * > visited;
+  std::vector< Op * > ordered_ops;
+  ordered_ops.reserve( output_graph.adj.size( ));
+  auto emit = [ &output_graph, &visited, &ordered_ops ]( Op *root ) {
+    /* ( op, its inputs are emitted ) */
+    std::vector< std::pair< Op *, bool > > pending = { { root, false } };
+    while ( ! pending.empty( )) {
+      auto top = pending.back( );
+      pending.pop_back( );
+      if ( top.second ) {
+        ordered_ops.push_back( top.first );
+        continue;
+      }
+      if ( ! visited.insert( top.first ).second )
+        continue;
+      pending.emplace_back( top.first, true );
+      auto &preds = output_graph.reverse_adj.at( top.first );
+      for ( auto it = preds.rbegin( ); it != preds.rend( ); it ++ ) {
+        if ( visited.count( *it ) == 0 )
+          pending.emplace_back( *it, false );
+      }
+    }
+  };
+  for ( auto op : placed_order ) {
+    if ( op != nullptr && ! output_graph.reverse_adj.at( op ).empty( ))
+      emit( op );
+  }
+  for ( auto op : placed_order ) {
+    if ( op != nullptr )
+      emit( op );
+  }
+  for ( auto e : output_graph.adj ) {
+    emit( e.first );
+  }
+  uint32_t new_prior = 0;
+  for ( auto op : ordered_ops ) {
+    op->priority = new_prior;
+    new_prior ++;
+  }
+  assert( new_prior == output_graph.adj.size( ));
+  return ExitStatus::SUCCESS;
+}
 
+ExitStatus BasePlacement::set_calibration( const EstimatorCalibration &estimator_calibration ) {
+  calibration = estimator_calibration;
   return ExitStatus::SUCCESS;
 }
 
@@ -219,17 +360,44 @@ ExitStatus BasePlacement::add_dp_ring_reduce( CG &graph, std::vector< Op * > rep
   return ExitStatus::SUCCESS;
 }
 
-uint16_t ring_dist( uint16_t a, uint16_t b, uint16_t ring_size ) {
+DeviceId ring_dist( DeviceId a, DeviceId b, DeviceId ring_size ) {
   /* number of hops from a to b  */
-  int dist = ( b >= a ? b - a : ring_size - ( a - b ));
+  DeviceId dist = ( b >= a ? b - a : ring_size - ( a - b ));
   return dist;
 }
 
+ExitStatus BasePlacement::async_transfer_bytes( Op *src_op, Op *dst_op, uint32_t &num_transfer_bytes ) {
+  uint16_t src_batch;
+  uint16_t dst_batch;
+
+  if ( src_op->type == OpType::COMPUTE && dst_op->type == OpType::COMPUTE ) {
+    /* only send the needed samples in the batch */
+    static_cast<CompOp *>(src_op)->get_batch_size( src_batch ).ok( );
+    static_cast<CompOp *>(dst_op)->get_batch_size( dst_batch ).ok( );
+//    std::cout << "src_batch=" << src_batch << " "
+//              << "dst_batch=" << dst_batch << " "
+//              << std::endl;
+    double ratio = double( dst_batch ) / double( src_batch );
+//    std::cout << "src_batch=" << src_batch << " "
+//              << "dst_batch=" << dst_batch << " "
+//              << "ratio="     << ratio     << " "
+//              << std::endl;
+    num_transfer_bytes = static_cast<CompOp *>(src_op)->output_bytes;
+    num_transfer_bytes = ratio * double( num_transfer_bytes ); /* just the send required samples */
+//    std::cout << num_transfer_bytes << std::endl;
+  } else if ( src_op->type == OpType::COMPUTE ) {
+    num_transfer_bytes = static_cast<CompOp *>(src_op)->output_bytes;
+  } else if ( src_op->type == OpType::MEMORY ) {
+    num_transfer_bytes = static_cast<MemOp *>(src_op)->num_bytes;
+  } else {
+    return ExitStatus::FAILURE;
+  }
+  return ExitStatus::SUCCESS;
+}
+
 ExitStatus BasePlacement::add_async_netops( CG &output_graph ) {
   NetOp *net_op;
   Op *src_op;
-  uint16_t src_batch;
-  uint16_t dst_batch;
 
   for ( auto e : output_graph.adj ) {
     src_op = e.first;
@@ -240,26 +408,7 @@ ExitStatus BasePlacement::add_async_netops( CG &output_graph ) {
           ( src_op->type == OpType::COMPUTE || src_op->type == OpType::MEMORY ) &&
           ( dst_op->type == OpType::COMPUTE || dst_op->type == OpType::MEMORY )) {
         uint32_t num_transfer_bytes;
-        if ( src_op->type == OpType::COMPUTE && dst_op->type == OpType::COMPUTE ) {
-          /* only send the needed samples in the batch */
-          static_cast<CompOp *>(src_op)->get_batch_size( src_batch ).ok( );
-          static_cast<CompOp *>(dst_op)->get_batch_size( dst_batch ).ok( );
-//          std::cout << "src_batch=" << src_batch << " "
-//                    << "dst_batch=" << dst_batch << " "
-//                    << std::endl;
-          double ratio = double( dst_batch ) / double( src_batch );
-//          std::cout << "src_batch=" << src_batch << " "
-//                    << "dst_batch=" << dst_batch << " "
-//                    << "ratio="     << ratio     << " "
-//                    << std::endl;
-          num_transfer_bytes = static_cast<CompOp *>(src_op)->output_bytes;
-          num_transfer_bytes = ratio * double( num_transfer_bytes ); /* just the send required samples */
-//          std::cout << num_transfer_bytes << std::endl;
-        } else if ( src_op->type == OpType::COMPUTE ) {
-          num_transfer_bytes = static_cast<CompOp *>(src_op)->output_bytes;
-        } else if ( src_op->type == OpType::MEMORY ) {
-          num_transfer_bytes = static_cast<MemOp *>(src_op)->num_bytes;
-        } else {
+        if ( async_transfer_bytes( src_op, dst_op, num_transfer_bytes ) != ExitStatus::SUCCESS ) {
           throw std::runtime_error( "Didn't expect this type of communication" );
         }
         if ( num_transfer_bytes > 0 ) { //todo: route the others through pcie
@@ -294,7 +443,7 @@ ExitStatus BasePlacement::add_async_netops( CG &output_graph ) {
 //}
 
 
-ExitStatus BasePlacement::add_sync_netops( CG &output_graph, std::map< Op *, std::vector< Op *>> &replicas ) {
+ExitStatus BasePlacement::add_sync_netops( CG &output_graph, OpMap< std::vector< Op * > > &replicas ) {
   MemOp *mem_op;
   for ( auto rop : replicas ) {
     if ( rop.first->type == OpType::MEMORY ) {
@@ -307,7 +456,7 @@ ExitStatus BasePlacement::add_sync_netops( CG &output_graph, std::map< Op *, std
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus BasePlacement::add_dp_sync_netops( CG &output_graph, std::map< Op *, std::vector< Op *>> &replicas, int dp_degree ) {
+ExitStatus BasePlacement::add_dp_sync_netops( CG &output_graph, OpMap< std::vector< Op * > > &replicas, int dp_degree ) {
   MemOp *mem_op;
   for ( auto rop : replicas ) {
     if ( rop.first->type == OpType::MEMORY ) {
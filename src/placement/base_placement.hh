@@ -3,12 +3,18 @@
 #include "op.hh"
 #include "graph.hh"
 #include "base_interconnect.hh"
+#include "estimator_calibration.hh"
+
+/* bytes per step between each pair of gpus; see offline_bw_est( ) */
+using BWEstimate = std::unordered_map< Device *, std::unordered_map< Device *, double > >;
 
 class BasePlacement {
  protected:
   BaseInterconnect *interconnect;
   GPU *gpus;
   uint32_t num_gpus;
+  /* applied by estimate_iter_time( ) */
+  EstimatorCalibration calibration;
  protected:
   virtual ExitStatus num_batch_splits( Op *op, uint32_t &num_splits ) = 0;
 
@@ -25,7 +31,11 @@ class BasePlacement {
   ExitStatus add_async_netops( CG &output_graph );
 
 //  ExitStatus add_sync_netops( CG &output_graph, std::unordered_map< Op *, std::vector< Op *>> &replicas );
-  ExitStatus add_sync_netops( CG &output_graph, std::map< Op *, std::vector< Op *>> &replicas );
+  ExitStatus add_sync_netops( CG &output_graph, OpMap< std::vector< Op * > > &replicas );
+
+  /* unique priorities for every op of output_graph, in a topological order
+   * that follows the replicas' priorities from placement */
+  ExitStatus fix_priorities( CG &output_graph, const OpMap< std::vector< Op * > > &replicas );
 
  public:
   virtual ExitStatus find_placement( CG &output_graph ) = 0;
@@ -34,9 +44,17 @@ class BasePlacement {
 
   ExitStatus estimate_iter_time( CG &graph, Step &num_steps_est );
 
+  /* list-schedule the placed graph in priority order: an op waits for its
+   * inputs, a compute op for its gpu, and a network op for its pair's
+   * channel and the tx and rx ports at both ends, with no traffic while
+   * the interconnect reconfigures. Sets every op's start and end, in
+   * O( V + E ) when the priorities are at most twice the number of ops, as
+   * fix_priorities( ) leaves them */
+  ExitStatus estimate_iter_time( const CG &graph, const BWEstimate &bw_est, Step &num_steps_est ) const;
+
  public:
   BasePlacement( BaseInterconnect *interconnect, GPU *gpus, uint32_t num_gpus, const CG &input_graph )
-      : interconnect( interconnect ), gpus( gpus ), num_gpus( num_gpus ), input_graph( input_graph ) { }
+      : interconnect( interconnect ), gpus( gpus ), num_gpus( num_gpus ), calibration( ), input_graph( input_graph ) { }
 
   BasePlacement( const BasePlacement & ) = delete;
 
@@ -44,7 +62,12 @@ class BasePlacement {
 
   virtual ~BasePlacement( ) = default;
 
-  ExitStatus add_dp_sync_netops( CG &output_graph, std::map< Op *, std::vector< Op *>> &replicas, int dp_degree );
+  ExitStatus set_calibration( const EstimatorCalibration &estimator_calibration );
+
+  /* bytes add_async_netops( ) copies from src_op to dst_op on another gpu */
+  static ExitStatus async_transfer_bytes( Op *src_op, Op *dst_op, uint32_t &num_transfer_bytes );
+
+  ExitStatus add_dp_sync_netops( CG &output_graph, OpMap< std::vector< Op * > > &replicas, int dp_degree );
 
   ExitStatus add_dp_ring_reduce( CG &graph, std::vector< Op * > replicas, int dp_degree );
 };
@@ -0,0 +1,53 @@
+#include <fstream>
+#include <sstream>
+#include "estimator_calibration.hh"
+
+using namespace std;
+
+string EstimatorCalibration::topology_name( const InterType inter_type ) {
+  switch ( inter_type ) {
+    case InterType::ELECTSW: return "elect";
+    case InterType::FULLMESH: return "fullmesh";
+    case InterType::OCS: return "ocs";
+    case InterType::RING: return "ring";
+  }
+  return "";
+}
+
+ExitStatus EstimatorCalibration::load( const string &filename,
+                                       const InterType inter_type,
+                                       EstimatorCalibration &calibration ) {
+  ifstream in( filename );
+  if ( ! in )
+    return ExitStatus::FAILURE;
+  const string topology = topology_name( inter_type );
+  string line;
+  while ( getline( in, line )) {
+    istringstream fields( line );
+    string name;
+    if ( ! ( fields >> name ) || name[ 0 ] == '#' || name != topology )
+      continue;
+    EstimatorCalibration entry;
+    string field;
+    while ( fields >> field ) {
+      size_t eq = field.find( '=' );
+      if ( eq == string::npos )
+        return ExitStatus::FAILURE;
+      const string key = field.substr( 0, eq );
+      const double value = stod( field.substr( eq + 1 ));
+      if ( key == "bw_efficiency" )
+        entry.bw_efficiency = value;
+      else if ( key == "net_overhead_sec" )
+        entry.net_overhead_sec = value;
+    }
+    calibration = entry;
+    return ExitStatus::SUCCESS;
+  }
+  return ExitStatus::NOT_AVAILABLE;
+}
+
+string EstimatorCalibration::to_string( const string &topology ) const {
+  ostringstream line;
+  line << topology << " bw_efficiency=" << bw_efficiency << " net_overhead_sec=" << net_overhead_sec;
+  return line.str( );
+}
@@ -0,0 +1,26 @@
+#ifndef SIPML_SRC_PLACEMENT_ESTIMATOR_CALIBRATION_HH_
+#define SIPML_SRC_PLACEMENT_ESTIMATOR_CALIBRATION_HH_
+#include <string>
+#include "exit_status.hh"
+#include "sim_config.hh"
+
+/* corrections to BasePlacement::estimate_iter_time( ) for one kind of
+ * interconnect, fitted against simulations by sipml-sweep --fit_calibration */
+struct EstimatorCalibration {
+  /* share of the offline bandwidth estimate that transfers actually get */
+  double bw_efficiency = 1.0;
+  /* added to every transfer, e.g. for waiting on reconfigurations */
+  double net_overhead_sec = 0;
+
+  /* elect, fullmesh, ocs or ring, as in calibration files and sweep specs */
+  static std::string topology_name( InterType inter_type );
+
+  /* the entry for inter_type in filename; NOT_AVAILABLE if there is none,
+   * FAILURE if the file can't be read */
+  static ExitStatus load( const std::string &filename, InterType inter_type, EstimatorCalibration &calibration );
+
+  /* one line of a calibration file */
+  std::string to_string( const std::string &topology ) const;
+};
+
+#endif //SIPML_SRC_PLACEMENT_ESTIMATOR_CALIBRATION_HH_
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <limits>
+#include <stack>
+#include <unordered_map>
+#include "heft.hh"
+
+ExitStatus HEFT::num_batch_splits( Op *, uint32_t & ) {
+  return ExitStatus::FAILURE;
+}
+
+Step HEFT::duration( Op *op ) const {
+  const SimConfig &cnfg = interconnect->cnfg;
+  if ( op->type == OpType::COMPUTE ) {
+    Step comp_time = static_cast<CompOp *>( op )->comp_time;
+    comp_time = ( comp_time < cnfg.gpu_min_comp_time ? cnfg.gpu_min_comp_time : comp_time );
+    return comp_time + cnfg.gpu_launch_latency;
+  } else if ( op->type == OpType::MEMORY ) {
+    return 1;
+  }
+  return 0;
+}
+
+double HEFT::transfer_time( Op *src_op, Op *dst_op, const double bw ) const {
+  /* only what add_async_netops( ) sends */
+  if (( src_op->type != OpType::COMPUTE && src_op->type != OpType::MEMORY ) ||
+      ( dst_op->type != OpType::COMPUTE && dst_op->type != OpType::MEMORY ))
+    return 0;
+  uint32_t num_transfer_bytes;
+  async_transfer_bytes( src_op, dst_op, num_transfer_bytes ).ok( );
+  if ( num_transfer_bytes == 0 )
+    return 0;
+  return double( num_transfer_bytes ) / bw + interconnect->cnfg.interconnect_latency;
+}
+
+ExitStatus HEFT::place_heft( CG &output_graph ) {
+  const size_t n = avail_gpus;
+  /* the bandwidth estimate_iter_time( ) gives each pair, and its mean for
+   * ranking ops that are not placed yet */
+  double tx_bw, rx_bw;
+  interconnect->offline_port_bw_est( tx_bw, rx_bw ).ok( );
+  tx_bw *= calibration.bw_efficiency;
+  rx_bw *= calibration.bw_efficiency;
+  vector< double > pair_bw( n * n );
+  double mean_bw = 0;
+  for ( size_t i = 0; i < n; i ++ ) {
+    for ( size_t j = 0; j < n; j ++ ) {
+      pair_bw[ i * n + j ] = min( { bw_est.at( &gpus[ i ] ).at( &gpus[ j ] ) * calibration.bw_efficiency, tx_bw, rx_bw } );
+      if ( i != j )
+        mean_bw += pair_bw[ i * n + j ];
+    }
+  }
+  mean_bw = ( n > 1 ? mean_bw / double( n * ( n - 1 )) : min( tx_bw, rx_bw ));
+
+  /* upward ranks, from the end of the graph back */
+  stack< Op * > sorted_graph;
+  output_graph.topological_sort( sorted_graph );
+  vector< Op * > sorted_ops;
+  sorted_ops.reserve( output_graph.adj.size( ));
+  while ( ! sorted_graph.empty( )) {
+    sorted_ops.push_back( sorted_graph.top( ));
+    sorted_graph.pop( );
+  }
+  unordered_map< Op *, double > rank;
+  for ( auto it = sorted_ops.rbegin( ); it != sorted_ops.rend( ); it ++ ) {
+    double tail = 0;
+    for ( auto succ : output_graph.adj.at( *it ))
+      tail = max( tail, transfer_time( *it, succ, mean_bw ) + rank.at( succ ));
+    rank[ *it ] = duration( *it ) + tail;
+  }
+  /* an op ranks at least as high as its successors, so going by rank, and
+   * by topological order on ties, places every op after its inputs */
+  vector< size_t > order( sorted_ops.size( ));
+  for ( size_t i = 0; i < order.size( ); i ++ )
+    order[ i ] = i;
+  stable_sort( order.begin( ), order.end( ), [ & ]( size_t a, size_t b ) {
+    return rank.at( sorted_ops[ a ] ) > rank.at( sorted_ops[ b ] );
+  } );
+
+  /* each op on the gpu it finishes first on, the lowest one on ties */
+  vector< double > gpu_avail_time( n, 0 );
+  vector< uint64_t > used_memory( n, 0 );
+  unordered_map< Op *, double > finish;
+  uint32_t priority = 0;
+  for ( auto i : order ) {
+    Op *op = sorted_ops[ i ];
+    uint64_t mem_size;
+    op->get_mem_size( mem_size ).ok( );
+    const Step op_duration = duration( op );
+    size_t best_dev_id = n;
+    double best_finish = numeric_limits< double >::max( );
+    for ( size_t dev_id = 0; dev_id < n; dev_id ++ ) {
+      uint64_t total_mem;
+      gpus[ dev_id ].get_total_memsize( total_mem ).ok( );
+      if ( mem_size + used_memory[ dev_id ] > total_mem )
+        continue;
+      double start = gpu_avail_time[ dev_id ];
+      for ( auto pred : output_graph.reverse_adj.at( op )) {
+        const DeviceId pred_dev_id = pred->device->dev_id;
+        double arrival = finish.at( pred );
+        if ( pred_dev_id != dev_id )
+          arrival += transfer_time( pred, op, pair_bw[ pred_dev_id * n + dev_id ] );
+        start = max( start, arrival );
+      }
+      if ( start + op_duration < best_finish ) {
+        best_finish = start + op_duration;
+        best_dev_id = dev_id;
+      }
+    }
+    if ( best_dev_id == n )
+      return ExitStatus::NOT_AVAILABLE;
+    op->device = &gpus[ best_dev_id ];
+    op->priority = priority;
+    priority ++;
+    used_memory[ best_dev_id ] += mem_size;
+    gpu_avail_time[ best_dev_id ] = best_finish;
+    finish[ op ] = best_finish;
+  }
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus HEFT::find_placement( CG &output_graph ) {
+  if ( place_heft( output_graph ) != ExitStatus::SUCCESS )
+    return ExitStatus::NOT_AVAILABLE;
+
+  /* add network ops */
+  add_async_netops( output_graph ).ok( );
+
+  /* fix all the priorities */
+  fix_priorities( output_graph, parallel_ops_map ).ok( );
+
+  add_sync_netops( output_graph, parallel_ops_map ).ok( );
+  return ExitStatus::SUCCESS;
+}
@@ -0,0 +1,48 @@
+#ifndef SIPML_SRC_PLACEMENT_HEFT_HH_
+#define SIPML_SRC_PLACEMENT_HEFT_HH_
+#include "base_placement.hh"
+
+using namespace std;
+
+/* Heterogeneous Earliest Finish Time list scheduling of the replicas on
+ * the first avail_gpus gpus. Replicas go in decreasing upward rank, their
+ * own cost plus the costliest path of compute and average transfer times
+ * to the end of the graph, and each goes on the gpu where it would finish
+ * first, counting the transfers from its inputs on other gpus at the
+ * offline_bw_est( ) bandwidth of the pair. Unlike MP, this is not bound to
+ * a window of the ring */
+class HEFT : public BasePlacement {
+ private:
+  OpMap< vector< Op * > > parallel_ops_map;
+  int avail_gpus;
+  const BWEstimate &bw_est;
+
+  /* steps the op takes on a gpu, as MP counts them */
+  Step duration( Op *op ) const;
+
+  /* steps to move the bytes of src_op to dst_op at bw bytes per step */
+  double transfer_time( Op *src_op, Op *dst_op, double bw ) const;
+
+ public:
+  HEFT( BaseInterconnect *interconnect,
+        GPU *gpus,
+        uint32_t num_gpus,
+        const CG &input_graph,
+        const OpMap< vector< Op * > > &parallel_ops_map,
+        int avail_gpus,
+        const BWEstimate &bw_est ) : BasePlacement( interconnect, gpus, num_gpus, input_graph ),
+                                     parallel_ops_map( parallel_ops_map ),
+                                     avail_gpus( avail_gpus ),
+                                     bw_est( bw_est ) { }
+
+ protected:
+  ExitStatus num_batch_splits( Op *op, uint32_t &num_splits ) override;
+
+ public:
+  ExitStatus find_placement( CG &output_graph ) override;
+
+  /* places the replicas of output_graph; NOT_AVAILABLE if they do not fit */
+  ExitStatus place_heft( CG &output_graph );
+};
+
+#endif //SIPML_SRC_PLACEMENT_HEFT_HH_
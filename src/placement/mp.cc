@@ -1,54 +1,44 @@
 #include "mp.hh"
 
-uint16_t ring_distance( uint16_t a, uint16_t b, uint16_t ring_size ) {
+DeviceId ring_distance( DeviceId a, DeviceId b, DeviceId ring_size ) {
   /* number of hops from a to b  */
-  int dist = ( b >= a ? b - a : ring_size - ( a - b ));
+  DeviceId dist = ( b >= a ? b - a : ring_size - ( a - b ));
   return dist;
 }
 
 ExitStatus MP::get_earliest_available( int &ready_dev_id,
-                                       const vector< Step > &v,
                                        const uint32_t start_offset,
                                        const uint32_t end_offset,
                                        uint64_t mem_size ) {
     //todo: doublecheck the uint32_t of offsets; it used to be int :)
-  uint32_t start = start_offset % v.size( );
-  //start = ( start < 0 ? start + v.size( ) : start );
+  const uint32_t size = avail_tree.size( );
+  uint32_t start = start_offset % size;
+  //start = ( start < 0 ? start + size : start );
   uint32_t end;
-  if ( end_offset - start_offset > v.size( )) {
-    end = 1 + ( start_offset + v.size( ) - 1 ) % v.size( );
+  if ( end_offset - start_offset > size ) {
+    end = 1 + ( start_offset + size - 1 ) % size;
   } else {
-    end = 1 + ( end_offset - 1 ) % v.size( );
+    end = 1 + ( end_offset - 1 ) % size;
   }
-  ready_dev_id = 0;
-  uint64_t avail_mem;
+  /* the range is scanned from start, wrapping around the ring, and a gpu
+   * is only picked over gpu 0 if it is available strictly earlier */
+  size_t best = AvailTree::none;
   if ( start >= end ) {
-    for ( size_t i = start; i < v.size( ); i ++ ) {
-      gpus[ i ].get_avail_memsize( avail_mem ).ok( );
-      if ( v.at( i ) < v.at( ready_dev_id ) && avail_mem > mem_size )
-        ready_dev_id = i;
-    }
-    for ( size_t i = 0; i < end; i ++ ) {
-      gpus[ i ].get_avail_memsize( avail_mem ).ok( );
-      if ( v.at( i ) < v.at( ready_dev_id ) && avail_mem > mem_size )
-        ready_dev_id = i;
-    }
+    avail_tree.earliest( start, size, mem_size, best );
+    size_t wrapped;
+    if ( avail_tree.earliest( 0, end, mem_size, wrapped ) == ExitStatus::SUCCESS
+        && ( best == AvailTree::none || avail_tree.time( wrapped ) < avail_tree.time( best )))
+      best = wrapped;
   } else {
-    for ( size_t i = start; i < end; i ++ ) {
-      gpus[ i ].get_avail_memsize( avail_mem ).ok( );
-      if ( v.at( i ) < v.at( ready_dev_id ) && avail_mem > mem_size ) {
-        ready_dev_id = i;
-      }
-    }
+    avail_tree.earliest( start, end, mem_size, best );
   }
+  ready_dev_id = ( best != AvailTree::none && avail_tree.time( best ) < avail_tree.time( 0 ) ? int( best ) : 0 );
   return ExitStatus::SUCCESS;
 }
 
 ExitStatus MP::place_partitions_heuristic( CG &output_graph ) {
-  /* make sure all gpu stats are reset */
-  for ( size_t i = 0; i < num_gpus; i ++ ) {
-    gpus[ i ].release_mem_all( );
-  }
+  /* start with all the gpus empty */
+  used_memory.assign( num_gpus, 0 );
   stack< Op * > rev_sorted_graph;
   stack< Op * > sorted_graph;
   input_graph.topological_sort( sorted_graph );
@@ -77,9 +67,14 @@ ExitStatus MP::place_partitions_heuristic( CG &output_graph ) {
   vector< Step > comp_avail_time;
   map< Op *, Step > start;
   map< Op *, Step > end;
+  vector< uint64_t > free_mem;
   for ( int i = 0; i < avail_gpus; i ++ ) {
     comp_avail_time.push_back( Step( 0 ));
+    uint64_t total_mem;
+    gpus[ i ].get_total_memsize( total_mem ).ok( );
+    free_mem.push_back( total_mem );
   }
+  avail_tree.reset( comp_avail_time, free_mem ).ok( );
   while ( ! sorted_graph.empty( )) {
     main_op = sorted_graph.top( );
     for ( auto op : parallel_ops_map.at( main_op )) {
@@ -91,30 +86,33 @@ ExitStatus MP::place_partitions_heuristic( CG &output_graph ) {
         Step cand_start = 0;
         start[ op ] = std::numeric_limits< Step >::max( );
         end[ op ] = std::numeric_limits< Step >::max( );
-        uint16_t start_id_min = avail_gpus;
-        uint16_t start_id_max = 0;
+        int64_t start_id_min = avail_gpus;
+        int64_t start_id_max = 0;
         for ( auto pred : preds ) {
           cand_start = ( cand_start > end.at( pred ) ? cand_start : end.at( pred ));
           start_id_max = ( pred->device->dev_id > start_id_max ? pred->device->dev_id : start_id_max );
           start_id_min = ( pred->device->dev_id < start_id_min ? pred->device->dev_id : start_id_min );
         }
         /* set the leftmost as the start_id */
-        uint16_t start_id = ( start_id_max - start_id_min > start_id_min + avail_gpus - start_id_max ?
+        int64_t start_id = ( start_id_max - start_id_min > start_id_min + avail_gpus - start_id_max ?
             start_id_max : start_id_min );
-        uint16_t end_id = ( start_id_max - start_id_min > start_id_min + avail_gpus - start_id_max ?
+        int64_t end_id = ( start_id_max - start_id_min > start_id_min + avail_gpus - start_id_max ?
             start_id_min : start_id_max );
-        uint16_t range_lo = end_id;
-        uint16_t range_hi = start_id + d_max;
-        if ( ring_distance( range_lo, range_hi, avail_gpus ) > d_max ) {
+        int64_t range_lo = end_id;
+        int64_t range_hi = start_id + d_max;
+        if ( ring_distance( range_lo, range_hi, avail_gpus ) > DeviceId( d_max )) {
           range_hi = end_id;
         }
         uint64_t mem_size;
         op->get_mem_size( mem_size ).ok( );
-        get_earliest_available( ready_dev_id, comp_avail_time, range_lo, range_hi, mem_size );
+        get_earliest_available( ready_dev_id, range_lo, range_hi, mem_size );
         op->device = &gpus[ ready_dev_id ];
-        if ( gpus[ ready_dev_id ].allocate_mem( op ) != ExitStatus::SUCCESS ) {
+        uint64_t total_mem;
+        gpus[ ready_dev_id ].get_total_memsize( total_mem ).ok( );
+        if ( mem_size + used_memory[ ready_dev_id ] > total_mem ) {
           return ExitStatus::NOT_AVAILABLE;
         }
+        used_memory[ ready_dev_id ] += mem_size;
         start[ op ] = ( cand_start > comp_avail_time[ ready_dev_id ] ? cand_start : comp_avail_time[ ready_dev_id ] );
         Step duration;
         if ( op->type == OpType::COMPUTE ) {
@@ -130,6 +128,7 @@ ExitStatus MP::place_partitions_heuristic( CG &output_graph ) {
         end[ op ] = start[ op ] + duration;
         iter_time = ( iter_time < end[ op ] ? end[ op ] : iter_time );
         comp_avail_time[ ready_dev_id ] = end[ op ];
+        avail_tree.update( ready_dev_id, end[ op ], total_mem - used_memory[ ready_dev_id ] ).ok( );
       }
     }
     rev_sorted_graph.push( main_op );
@@ -152,38 +151,7 @@ ExitStatus MP::find_placement( CG &output_graph ) {
 //  add_global_dp_ops( output_graph ).ok( );
 
   /* fix all the priorities */
-  set< Op * > priorless_ops;
-  for ( auto e : output_graph.adj ) {
-    if ( e.first->priority == 0 ) {
-      priorless_ops.emplace( e.first );
-    }
-  }
-  std::map< uint32_t, Op * > run_order;
-  output_graph.priority_sort( run_order );
-  vector< Op * > ordered_ops;
-  while ( output_graph.adj.size( ) != run_order.size( )) {
-    set< Op * > visited;
-    for ( uint32_t prior = 0; prior < run_order.size( ); prior ++ ) {
-      Op *prior_op = run_order.at( prior );
-      for ( auto pred : output_graph.reverse_adj.at( prior_op )) {
-        if ( visited.count( pred ) == 0 ) {
-          visited.emplace( pred );
-          ordered_ops.push_back( pred );
-        }
-        visited.emplace( prior_op );
-        ordered_ops.push_back( prior_op );
-      }
-    }
-    uint32_t new_prior = 0;
-    for ( auto op : ordered_ops ) {
-      op->priority = new_prior;
-      new_prior ++;
-    }
-    assert( new_prior == ordered_ops.size( ));
-    run_order.clear( );
-    output_graph.priority_sort( run_order );
-  }
-  assert( output_graph.adj.size( ) == run_order.size( ));
+  fix_priorities( output_graph, parallel_ops_map ).ok( );
 
   add_sync_netops( output_graph, parallel_ops_map ).ok( );
 
@@ -203,8 +171,8 @@ ExitStatus MP::add_global_dp_ops( CG &output_graph ) {
   uint32_t mp_degree = avail_gpus;
   if ( dp_degree == 1 )
     return ExitStatus::SUCCESS;
-  map< Op *, Op * > cntrl_ops_map;
-  map< Op *, vector< Op * > > global_mem_ops_map;
+  OpMap< Op * > cntrl_ops_map;
+  OpMap< vector< Op * > > global_mem_ops_map;
   for ( auto e : output_graph.adj ) {
     if ( e.first->type == OpType::MEMORY ) {
       MemOp *mem_op;
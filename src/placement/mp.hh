@@ -1,25 +1,35 @@
 #ifndef ROSTAM_SRC_PLACEMENT_MP_HH_
 #define ROSTAM_SRC_PLACEMENT_MP_HH_
 #include "base_placement.hh"
+#include "avail_tree.hh"
 
 using namespace std;
 
 class MP : public BasePlacement {
  private:
-  map< Op *, vector< Op *>> parallel_ops_map;
+  OpMap< vector< Op * > > parallel_ops_map;
   int avail_gpus;
   int d_max;
+  /* memory taken on each device by the ops placed so far; kept by the
+   * placement instead of on the gpus, so placements sharing the gpus
+   * can run concurrently */
+  vector< uint64_t > used_memory;
+  /* when each gpu is next available and its memory left, for
+   * get_earliest_available( ) */
+  AvailTree avail_tree;
  public:
   MP( BaseInterconnect *interconnect,
       GPU *gpus,
       uint32_t num_gpus,
       const CG &input_graph,
-      const map< Op *, vector< Op *>> &parallel_ops_map,
+      const OpMap< vector< Op * > > &parallel_ops_map,
       int avail_gpus,
       int d_max ) : BasePlacement( interconnect, gpus, num_gpus, input_graph ),
                     parallel_ops_map( parallel_ops_map ),
                     avail_gpus( avail_gpus ),
-                    d_max( d_max ) { }
+                    d_max( d_max ),
+                    used_memory( ),
+                    avail_tree( ) { }
 
  protected:
   ExitStatus num_batch_splits( Op *op, uint32_t &num_splits ) override;
@@ -29,8 +39,9 @@ class MP : public BasePlacement {
 
   ExitStatus place_partitions_heuristic( CG &output_graph );
 
+  /* the gpu of the ring range that is available first and has more than
+   * mem_size bytes left, or gpu 0 if none is available before it */
   ExitStatus get_earliest_available( int &ready_dev_id,
-                                     const vector< Step > &v,
                                      uint32_t start_offset,
                                      uint32_t end_offset,
                                      uint64_t mem_size );
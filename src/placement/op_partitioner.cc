@@ -1,3 +1,5 @@
+#include <limits>
+#include <stack>
 #include "op_partitioner.hh"
 
 ExitStatus OpPartitioner::split_compute( CompOp *op, uint32_t &num_splits ) {
@@ -37,49 +39,52 @@ ExitStatus OpPartitioner::split_memory( MemOp *op,
 }
 
 ExitStatus OpPartitioner::get_nsplits_all( map< Op *, uint32_t > &splits_map ) {
-  stack< Op * > sorted_graph;
-  stack< Op * > rev_sorted_graph;
-  input_graph.topological_sort( sorted_graph );
   /* first divide the compute ops */
   uint32_t num_splits;
-  Op *op;
-  while ( ! sorted_graph.empty( )) {
-    op = sorted_graph.top( );
-    if ( op->type == OpType::COMPUTE ) {
-      split_compute( dynamic_cast<CompOp *>(op), num_splits ).ok( );
-      splits_map[ op ] = num_splits;
-    } else {
-      rev_sorted_graph.push( op );
+  for ( auto &e : input_graph.adj ) {
+    if ( e.first->type == OpType::COMPUTE ) {
+      split_compute( dynamic_cast<CompOp *>(e.first), num_splits ).ok( );
+      splits_map[ e.first ] = num_splits;
     }
-    sorted_graph.pop( );
   }
+  return complete_splits( splits_map );
+}
 
+ExitStatus OpPartitioner::complete_splits( map< Op *, uint32_t > &splits_map ) {
   /* now that all compute ops are partionted, 
    * split the rest according to the compute ops */
-  while ( ! rev_sorted_graph.empty( )) {
-    op = rev_sorted_graph.top( );
-    if ( op->type == OpType::MEMORY ) {
+  uint32_t num_splits;
+  for ( auto &e : input_graph.adj ) {
+    Op *op = e.first;
+    if ( op->type == OpType::COMPUTE ) {
+      continue;
+    } else if ( op->type == OpType::MEMORY ) {
       split_memory( dynamic_cast<MemOp *>(op), splits_map, num_splits ).ok( );
       splits_map[ op ] = num_splits;
     } else if ( op->type == OpType::CONTROL_DEPENDENCY ) {
       splits_map[ op ] = 1;
     } else
       throw runtime_error( "This type of op not predicted." );
-    rev_sorted_graph.pop( );
   }
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus OpPartitioner::partition( CG &output_graph, map< Op *, vector< Op *>> &parallel_ops_map ) {
+ExitStatus OpPartitioner::partition( CG &output_graph, OpMap< vector< Op * > > &parallel_ops_map ) {
   map< Op *, uint32_t > splits_map;
   get_nsplits_all( splits_map ).ok( );
+  return partition( splits_map, output_graph, parallel_ops_map );
+}
+
+ExitStatus OpPartitioner::partition( const map< Op *, uint32_t > &splits_map,
+                                     CG &output_graph,
+                                     OpMap< vector< Op * > > &parallel_ops_map ) {
   create_parallel_ops( splits_map, parallel_ops_map ).ok( );
   add_data_dependencies( parallel_ops_map, output_graph );
   return ExitStatus::SUCCESS;
 }
 
 ExitStatus OpPartitionerSample::create_parallel_ops( const map< Op *, uint32_t > &splits_map,
-                                                     map< Op *, vector< Op *>> &parallel_ops_map ) {
+                                                     OpMap< vector< Op * > > &parallel_ops_map ) {
   for ( auto &e : input_graph.adj ) {
     Op *op = e.first;
     uint32_t num_splits = splits_map.at( op );
@@ -140,7 +145,7 @@ ExitStatus OpPartitionerSample::create_parallel_ops( const map< Op *, uint32_t >
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus OpPartitionerSample::add_data_dependencies( const map< Op *, vector< Op *>> &parallel_ops_map,
+ExitStatus OpPartitionerSample::add_data_dependencies( const OpMap< vector< Op * > > &parallel_ops_map,
                                                        CG &output_graph ) {
   for ( auto &e : input_graph.adj ) {
     Op *src = e.first;
@@ -179,7 +184,7 @@ OpPartitionerSample::OpPartitionerSample( Step quant_step,
     input_graph ) { }
 
 ExitStatus OpPartitionerParam::create_parallel_ops( const map< Op *, uint32_t > &splits_map,
-                                                    map< Op *, vector< Op *>> &parallel_ops_map ) {
+                                                    OpMap< vector< Op * > > &parallel_ops_map ) {
   for ( auto &e : input_graph.adj ) {
     Op *op = e.first;
     uint32_t num_splits = splits_map.at( op );
@@ -237,7 +242,7 @@ ExitStatus OpPartitionerParam::create_parallel_ops( const map< Op *, uint32_t >
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus OpPartitionerParam::add_data_dependencies( const map< Op *, vector< Op *>> &parallel_ops_map,
+ExitStatus OpPartitionerParam::add_data_dependencies( const OpMap< vector< Op * > > &parallel_ops_map,
                                                       CG &output_graph ) {
   for ( auto &e : input_graph.adj ) {
     Op *src = e.first;
@@ -291,7 +296,7 @@ OpPartitionerAttribute::OpPartitionerAttribute( Step quant_step,
                                                                                          input_graph ) { }
 
 ExitStatus OpPartitionerAttribute::create_parallel_ops( const map< Op *, uint32_t > &splits_map,
-                                                        map< Op *, vector< Op *>> &parallel_ops_map ) {
+                                                        OpMap< vector< Op * > > &parallel_ops_map ) {
   for ( auto &e : input_graph.adj ) {
     Op *op = e.first;
     uint32_t num_splits = splits_map.at( op );
@@ -356,33 +361,87 @@ ExitStatus OpPartitionerAttribute::create_parallel_ops( const map< Op *, uint32_
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus OpPartitionerAttribute::add_data_dependencies( const map< Op *, vector< Op *>> &parallel_ops_map,
+ExitStatus OpPartitionerAttribute::add_data_dependencies( const OpMap< vector< Op * > > &parallel_ops_map,
                                                           CG &output_graph ) {
   for ( auto &e : input_graph.adj ) {
     Op *src = e.first;
     for ( auto dst : e.second ) {
-      auto src_size = parallel_ops_map.at( src ).size( );
-      auto dst_size = parallel_ops_map.at( dst ).size( );
-      if ( src_size >= dst_size ) {
-        uint32_t r;
-        r = src_size / dst_size;
-        for ( uint32_t i = 0; i < dst_size; i ++ ) {
-          for ( uint32_t j = 0; j < r; j ++ ) {
-            output_graph.add_edge( parallel_ops_map.at( src )[ i * r + j ],
-                                   parallel_ops_map.at( dst )[ i ] );
-          }
-        }
-      } else {
-        uint32_t r;
-        r = dst_size / src_size;
-        for ( uint32_t i = 0; i < src_size; i ++ ) {
-          for ( uint32_t j = 0; j < r; j ++ ) {
-            output_graph.add_edge( parallel_ops_map.at( src )[ i ],
-                                   parallel_ops_map.at( dst )[ i * r + j ] );
-          }
+      auto &src_reps = parallel_ops_map.at( src );
+      auto &dst_reps = parallel_ops_map.at( dst );
+      const uint64_t src_size = src_reps.size( );
+      const uint64_t dst_size = dst_reps.size( );
+      /* replica i of n holds [ i / n, ( i + 1 ) / n ) of the tensor, and
+       * feeds the replicas it overlaps; when one count divides the other
+       * this is the usual one-to-many or many-to-one */
+      uint64_t i = 0;
+      uint64_t j = 0;
+      while ( i < src_size && j < dst_size ) {
+        output_graph.add_edge( src_reps[ i ], dst_reps[ j ] );
+        if ( ( i + 1 ) * dst_size < ( j + 1 ) * src_size )
+          i ++;
+        else if ( ( j + 1 ) * src_size < ( i + 1 ) * dst_size )
+          j ++;
+        else {
+          i ++;
+          j ++;
         }
       }
     }
   }
   return ExitStatus::SUCCESS;
 }
+
+OpPartitionerComm::OpPartitionerComm( Step quant_step,
+                                      const map< Op *, uint32_t > &max_splits,
+                                      const CG &input_graph,
+                                      const double port_bw,
+                                      const Step transfer_latency ) : OpPartitionerAttribute( quant_step,
+                                                                                              max_splits,
+                                                                                              input_graph ),
+                                                                      port_bw( port_bw ),
+                                                                      transfer_latency( transfer_latency ) { }
+
+double OpPartitionerComm::transfer_time( const uint32_t src_splits,
+                                         const uint32_t dst_splits,
+                                         const uint32_t num_bytes ) const {
+  if ( src_splits == dst_splits || num_bytes == 0 )
+    return 0;
+  /* all but min / max of the tensor changes gpus, through the ports of the
+   * min( ) replicas on the side with fewer of them */
+  const double fewer = min( src_splits, dst_splits );
+  const double more = max( src_splits, dst_splits );
+  return double( num_bytes ) * ( 1 - fewer / more ) / fewer / port_bw + double( transfer_latency );
+}
+
+ExitStatus OpPartitionerComm::get_nsplits_all( map< Op *, uint32_t > &splits_map ) {
+  stack< Op * > sorted_graph;
+  input_graph.topological_sort( sorted_graph );
+  while ( ! sorted_graph.empty( )) {
+    Op *op = sorted_graph.top( );
+    sorted_graph.pop( );
+    if ( op->type != OpType::COMPUTE )
+      continue;
+    CompOp *comp_op = static_cast< CompOp * >( op );
+    uint32_t max_num_splits;
+    split_compute( comp_op, max_num_splits ).ok( );
+    /* the powers of two below split_compute( )'s count, which may itself
+     * not be one when capped by max_splits, and the fewest replicas on
+     * ties, for the least traffic */
+    uint32_t best_splits = 1;
+    double best_time = numeric_limits< double >::max( );
+    for ( uint32_t num_splits = 1; num_splits <= max_num_splits;
+          num_splits = ( num_splits < max_num_splits && num_splits * 2 > max_num_splits ? max_num_splits : num_splits * 2 )) {
+      double time = double( comp_op->comp_time ) / num_splits;
+      for ( auto pred : input_graph.reverse_adj.at( op )) {
+        if ( pred->type == OpType::COMPUTE )
+          time += transfer_time( splits_map.at( pred ), num_splits, static_cast< CompOp * >( pred )->output_bytes );
+      }
+      if ( time < best_time ) {
+        best_time = time;
+        best_splits = num_splits;
+      }
+    }
+    splits_map[ op ] = best_splits;
+  }
+  return complete_splits( splits_map );
+}
@@ -17,18 +17,27 @@ class OpPartitioner {
 
   ExitStatus split_memory( MemOp *op, const map< Op *, uint32_t > &comp_splits_map, uint32_t &num_splits );
 
-  ExitStatus get_nsplits_all( map< Op *, uint32_t > &splits_map );
-
  public:
+  /* the number of replicas partition( ) makes of each op */
+  virtual ExitStatus get_nsplits_all( map< Op *, uint32_t > &splits_map );
+
+  /* given the splits of the compute ops, fills in those of the rest */
+  ExitStatus complete_splits( map< Op *, uint32_t > &splits_map );
+
   OpPartitioner( Step quant_step, const map< Op *, uint32_t > &max_splits, const CG &input_graph )
       : quant_step( quant_step ), max_splits( max_splits ), input_graph( input_graph ) { }
 
-  ExitStatus partition( CG &output_graph, map< Op *, vector< Op *>> &parallel_ops_map );
+  ExitStatus partition( CG &output_graph, OpMap< vector< Op * > > &parallel_ops_map );
+
+  /* partition( ) with the given number of replicas of each op */
+  ExitStatus partition( const map< Op *, uint32_t > &splits_map,
+                        CG &output_graph,
+                        OpMap< vector< Op * > > &parallel_ops_map );
 
   virtual ExitStatus create_parallel_ops( const map< Op *, uint32_t > &splits_map,
-                                          map< Op *, vector< Op * > > &parallel_ops_map ) = 0;
+                                          OpMap< vector< Op * > > &parallel_ops_map ) = 0;
 
-  virtual ExitStatus add_data_dependencies( const map< Op *, vector< Op * > > &parallel_ops_map, CG &output_graph ) = 0;
+  virtual ExitStatus add_data_dependencies( const OpMap< vector< Op * > > &parallel_ops_map, CG &output_graph ) = 0;
 
   virtual ~OpPartitioner( ) = default;
 };
@@ -38,9 +47,9 @@ class OpPartitionerSample : public OpPartitioner {
   OpPartitionerSample( Step quant_step, const map< Op *, uint32_t > &max_splits, const CG &input_graph );
 
   ExitStatus create_parallel_ops( const map< Op *, uint32_t > &splits_map,
-                                  map< Op *, vector< Op *>> &parallel_ops_map ) override;
+                                  OpMap< vector< Op * > > &parallel_ops_map ) override;
 
-  ExitStatus add_data_dependencies( const map< Op *, vector< Op *>> &parallel_ops_map, CG &output_graph ) override;
+  ExitStatus add_data_dependencies( const OpMap< vector< Op * > > &parallel_ops_map, CG &output_graph ) override;
 };
 
 class OpPartitionerAttribute : public OpPartitioner {
@@ -48,9 +57,9 @@ class OpPartitionerAttribute : public OpPartitioner {
   OpPartitionerAttribute( Step quant_step, const map< Op *, uint32_t > &max_splits, const CG &input_graph );
 
   ExitStatus create_parallel_ops( const map< Op *, uint32_t > &splits_map,
-                                  map< Op *, vector< Op *>> &parallel_ops_map ) override;
+                                  OpMap< vector< Op * > > &parallel_ops_map ) override;
 
-  ExitStatus add_data_dependencies( const map< Op *, vector< Op *>> &parallel_ops_map, CG &output_graph ) override;
+  ExitStatus add_data_dependencies( const OpMap< vector< Op * > > &parallel_ops_map, CG &output_graph ) override;
 };
 
 class OpPartitionerParam : public OpPartitioner {
@@ -58,9 +67,36 @@ class OpPartitionerParam : public OpPartitioner {
   OpPartitionerParam( Step quant_step, const map< Op *, uint32_t > &max_splits, const CG &input_graph );
 
   ExitStatus create_parallel_ops( const map< Op *, uint32_t > &splits_map,
-                                  map< Op *, vector< Op *>> &parallel_ops_map ) override;
+                                  OpMap< vector< Op * > > &parallel_ops_map ) override;
+
+  ExitStatus add_data_dependencies( const OpMap< vector< Op * > > &parallel_ops_map, CG &output_graph ) override;
+};
+
+/* OpPartitionerAttribute that splits a compute op only as far as it pays
+ * for the transfers it causes. Going through the graph in topological
+ * order, each compute op gets the power of two, up to what split_compute( )
+ * would give it, with the least compute time per replica plus time to
+ * bring in the outputs of its compute inputs whose replica counts differ
+ * from its own. The replicas whose slices overlap are taken to share a gpu,
+ * so inputs split the same way cost nothing */
+class OpPartitionerComm : public OpPartitionerAttribute {
+  /* bytes per step a gpu sends or receives */
+  double port_bw;
+  /* steps added to every transfer */
+  Step transfer_latency;
+
+  /* steps for the replicas of an op with dst_splits replicas to get
+   * num_bytes from an op with src_splits replicas */
+  double transfer_time( uint32_t src_splits, uint32_t dst_splits, uint32_t num_bytes ) const;
+
+ public:
+  OpPartitionerComm( Step quant_step,
+                     const map< Op *, uint32_t > &max_splits,
+                     const CG &input_graph,
+                     double port_bw,
+                     Step transfer_latency );
 
-  ExitStatus add_data_dependencies( const map< Op *, vector< Op *>> &parallel_ops_map, CG &output_graph ) override;
+  ExitStatus get_nsplits_all( map< Op *, uint32_t > &splits_map ) override;
 };
 
 #endif //ROSTAM_SRC_PLACEMENT_OP_PARTITIONER_HH_
@@ -0,0 +1,139 @@
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+#include "placement_cache.hh"
+
+using namespace std;
+
+namespace {
+/* 64-bit FNV-1a */
+class Hasher {
+ private:
+  uint64_t hash = 14695981039346656037ULL;
+ public:
+  template< class T >
+  Hasher &add( const T &value ) {
+    const unsigned char *bytes = reinterpret_cast< const unsigned char * >( &value );
+    for ( size_t i = 0; i < sizeof( T ); i ++ ) {
+      hash ^= bytes[ i ];
+      hash *= 1099511628211ULL;
+    }
+    return *this;
+  }
+
+  Hasher &add( const string &value ) {
+    add( value.size( ));
+    for ( auto c : value ) {
+      hash ^= static_cast< unsigned char >( c );
+      hash *= 1099511628211ULL;
+    }
+    return *this;
+  }
+
+  uint64_t value( ) const { return hash; }
+};
+}
+
+PlacementCache::PlacementCache( const string &cache_dir )
+    : cache_dir( cache_dir.empty( ) || cache_dir.back( ) == '/' ? cache_dir : cache_dir + "/" ) { }
+
+ExitStatus PlacementCache::key( const CG &input_graph, const string &params, string &key ) const {
+  /* what the placement reads of the input graph: the ops' sizes at their
+   * current batch size, in creation order, and the edges. Priorities and
+   * devices are left out, the placement assigns them */
+  Hasher hasher;
+  map< Op *, uint64_t > index;
+  hasher.add( input_graph.adj.size( ));
+  for ( auto e : input_graph.adj ) {
+    Op *op = e.first;
+    index.emplace( op, index.size( ));
+    hasher.add( int( op->type )).add( op->name ).add( op->session_id );
+    switch ( op->type ) {
+      case OpType::COMPUTE: {
+        auto comp_op = static_cast<CompOp *>( op );
+        uint16_t bs;
+        comp_op->get_batch_size( bs ).ok( );
+        hasher.add( bs ).add( comp_op->comp_time ).add( comp_op->output_bytes );
+        hasher.add( comp_op->comp_time_map.size( ));
+        for ( auto ct : comp_op->comp_time_map )
+          hasher.add( ct.first ).add( ct.second );
+        hasher.add( comp_op->output_bytes_map.size( ));
+        for ( auto ob : comp_op->output_bytes_map )
+          hasher.add( ob.first ).add( ob.second );
+      }
+        break;
+      case OpType::MEMORY: {
+        auto mem_op = static_cast<MemOp *>( op );
+        hasher.add( int( mem_op->mem_type )).add( mem_op->num_bytes );
+      }
+        break;
+      case OpType::NETWORK:hasher.add( static_cast<NetOp *>( op )->transfer_bytes );
+        break;
+      case OpType::CONTROL_DEPENDENCY:
+        break;
+    }
+  }
+  for ( auto e : input_graph.adj ) {
+    for ( auto succ : e.second )
+      hasher.add( index.at( e.first )).add( index.at( succ ));
+  }
+  hasher.add( params );
+
+  ostringstream hex_key;
+  hex_key << hex << setw( 16 ) << setfill( '0' ) << hasher.value( );
+  key = hex_key.str( );
+  return ExitStatus::SUCCESS;
+}
+
+string PlacementCache::digest( const vector< double > &values ) {
+  Hasher hasher;
+  hasher.add( values.size( ));
+  for ( double value : values )
+    hasher.add( value );
+  ostringstream hex_digest;
+  hex_digest << hex << setw( 16 ) << setfill( '0' ) << hasher.value( );
+  return hex_digest.str( );
+}
+
+ExitStatus PlacementCache::lookup( const string &key,
+                                   const string &params,
+                                   const function< Device *( DeviceType, DeviceId ) > &device_of,
+                                   ExitStatus &status,
+                                   CG &placed ) const {
+  ifstream in( cache_dir + key + ".placement" );
+  if ( ! in )
+    return ExitStatus::NOT_AVAILABLE;
+  string entry_params;
+  int fits;
+  if ( ! getline( in, entry_params ) || entry_params != params || ! ( in >> fits ))
+    return ExitStatus::NOT_AVAILABLE;
+  if ( ! fits ) {
+    status = ExitStatus::NOT_AVAILABLE;
+    return ExitStatus::SUCCESS;
+  }
+  if ( placed.load( in, device_of ) != ExitStatus::SUCCESS )
+    return ExitStatus::NOT_AVAILABLE;
+  status = ExitStatus::SUCCESS;
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus PlacementCache::store( const string &key, const string &params, const ExitStatus status, const CG &placed ) const {
+  static atomic< uint64_t > next_tmp( 0 );
+  const string path = cache_dir + key + ".placement";
+  const string tmp_path = path + ".tmp" + to_string( getpid( )) + "_" + to_string( next_tmp ++ );
+  ofstream out( tmp_path );
+  out << params << "\n";
+  out << ( status == ExitStatus::SUCCESS ? 1 : 0 ) << "\n";
+  if ( status == ExitStatus::SUCCESS )
+    placed.save( out ).ok( );
+  out.close( );
+  if ( ! out || rename( tmp_path.c_str( ), path.c_str( )) != 0 ) {
+    remove( tmp_path.c_str( ));
+    return ExitStatus::FAILURE;
+  }
+  return ExitStatus::SUCCESS;
+}
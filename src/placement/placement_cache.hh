@@ -0,0 +1,41 @@
+#ifndef SIPML_SRC_PLACEMENT_PLACEMENT_CACHE_HH_
+#define SIPML_SRC_PLACEMENT_PLACEMENT_CACHE_HH_
+#include <functional>
+#include <string>
+#include <vector>
+#include "exit_status.hh"
+#include "graph.hh"
+
+/* placed graphs kept on disk across runs, one file per placement problem.
+ * An entry is keyed by the contents of the input graph, at the batch size
+ * it is placed at, and by the parameters the partitioning and placement
+ * depend on, so runs that only differ in the interconnect share it. */
+class PlacementCache {
+ private:
+  const std::string cache_dir;
+
+ public:
+  /* the entries are files in cache_dir, with or without a trailing '/' */
+  explicit PlacementCache( const std::string &cache_dir );
+
+  /* the key of placing input_graph with params, which must name every
+   * other input of the placement */
+  ExitStatus key( const CG &input_graph, const std::string &params, std::string &key ) const;
+
+  /* a short stand-in, for params, of values too many to spell out */
+  static std::string digest( const std::vector< double > &values );
+
+  /* NOT_AVAILABLE on a miss. On a hit status is the placement's result,
+   * and placed the placed graph if that is SUCCESS */
+  ExitStatus lookup( const std::string &key,
+                     const std::string &params,
+                     const std::function< Device *( DeviceType, DeviceId ) > &device_of,
+                     ExitStatus &status,
+                     CG &placed ) const;
+
+  /* written to a temporary file and renamed, so concurrent runs never
+   * read a partial entry */
+  ExitStatus store( const std::string &key, const std::string &params, ExitStatus status, const CG &placed ) const;
+};
+
+#endif //SIPML_SRC_PLACEMENT_PLACEMENT_CACHE_HH_
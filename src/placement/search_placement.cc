@@ -0,0 +1,106 @@
+#include <cmath>
+#include <random>
+#include "search_placement.hh"
+#include "mp.hh"
+#include "op_partitioner.hh"
+
+ExitStatus SearchPlacement::num_batch_splits( Op *, uint32_t & ) {
+  return ExitStatus::FAILURE;
+}
+
+ExitStatus SearchPlacement::place( const map< Op *, uint32_t > &splits_map,
+                                   const int window,
+                                   CG &output_graph,
+                                   OpMap< vector< Op * > > &replicas,
+                                   Step &est_steps ) {
+  map< Op *, uint32_t > max_splits;
+  for ( auto e : input_graph.adj ) {
+    max_splits[ e.first ] = avail_gpus;
+  }
+  OpPartitionerAttribute partitioner( quant_step, max_splits, input_graph );
+  output_graph = CG( );
+  replicas.clear( );
+  partitioner.partition( splits_map, output_graph, replicas ).ok( );
+  MP pl( interconnect, gpus, num_gpus, input_graph, replicas, avail_gpus, window );
+  if ( pl.find_placement( output_graph ) != ExitStatus::SUCCESS ) {
+    /* nothing of the failed placement is left for the caller to keep */
+    output_graph.release_ops( ).ok( );
+    output_graph = CG( );
+    replicas.clear( );
+    return ExitStatus::NOT_AVAILABLE;
+  }
+  pl.add_dp_sync_netops( output_graph, replicas, avail_gpus ).ok( );
+  estimate_iter_time( output_graph, bw_est, est_steps ).ok( );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus SearchPlacement::find_placement( CG &output_graph ) {
+  map< Op *, uint32_t > max_splits;
+  vector< Op * > comp_ops;
+  for ( auto e : input_graph.adj ) {
+    max_splits[ e.first ] = avail_gpus;
+    if ( e.first->type == OpType::COMPUTE )
+      comp_ops.push_back( e.first );
+  }
+  OpPartitionerAttribute partitioner( quant_step, max_splits, input_graph );
+  map< Op *, uint32_t > splits_map;
+  partitioner.get_nsplits_all( splits_map ).ok( );
+  Step best_steps = 0;
+  int window = d_max;
+
+  /* only the best placement is kept; the walk moves between split counts */
+  bool has_current = ( place( splits_map, window, output_graph, parallel_ops_map, best_steps ) == ExitStatus::SUCCESS );
+  if ( ! has_current )
+    parallel_ops_map.clear( );
+  Step curr_steps = best_steps;
+
+  std::mt19937 rng( 0 );
+  for ( size_t iter = 0; iter < num_iterations && ! comp_ops.empty( ); iter ++ ) {
+    /* re-split one compute op to within a factor of two of its count, or
+     * move the window; with every memory op following its compute op */
+    map< Op *, uint32_t > cand_splits = splits_map;
+    int cand_window = window;
+    const size_t move = std::uniform_int_distribution< size_t >( 0, comp_ops.size( ))( rng );
+    if ( move == comp_ops.size( )) {
+      cand_window = std::uniform_int_distribution< int >( 1, avail_gpus )( rng );
+    } else {
+      const uint32_t num_splits = cand_splits.at( comp_ops[ move ] );
+      const uint32_t lo = max< uint32_t >( 1, num_splits / 2 );
+      const uint32_t hi = min< uint32_t >( avail_gpus, num_splits * 2 );
+      cand_splits[ comp_ops[ move ] ] = std::uniform_int_distribution< uint32_t >( lo, hi )( rng );
+    }
+    if ( cand_splits == splits_map && cand_window == window )
+      continue;
+    partitioner.complete_splits( cand_splits ).ok( );
+
+    CG cand_placed;
+    OpMap< vector< Op * > > cand_replicas;
+    Step cand_steps;
+    if ( place( cand_splits, cand_window, cand_placed, cand_replicas, cand_steps ) != ExitStatus::SUCCESS )
+      continue;
+    /* a worse point is moved to with a probability that drops as it gets
+     * worse and as the search cools down; at the start, a 5% slowdown
+     * over the best is even odds */
+    const double temperature = 0.05 / std::log( 2. ) * double( best_steps )
+        * double( num_iterations - iter ) / double( num_iterations );
+    const bool accept = ( ! has_current || cand_steps <= curr_steps
+        || ( temperature > 0 && std::uniform_real_distribution< double >( 0, 1 )( rng )
+            < std::exp( - double( cand_steps - curr_steps ) / temperature )));
+    if ( parallel_ops_map.empty( ) || cand_steps < best_steps ) {
+      if ( ! parallel_ops_map.empty( ))
+        output_graph.release_ops( ).ok( );
+      output_graph = cand_placed;
+      parallel_ops_map = cand_replicas;
+      best_steps = cand_steps;
+    } else {
+      cand_placed.release_ops( ).ok( );
+    }
+    if ( accept ) {
+      splits_map = cand_splits;
+      window = cand_window;
+      curr_steps = cand_steps;
+      has_current = true;
+    }
+  }
+  return ( parallel_ops_map.empty( ) ? ExitStatus::NOT_AVAILABLE : ExitStatus::SUCCESS );
+}
@@ -0,0 +1,58 @@
+#ifndef SIPML_SRC_PLACEMENT_SEARCH_PLACEMENT_HH_
+#define SIPML_SRC_PLACEMENT_SEARCH_PLACEMENT_HH_
+#include "base_placement.hh"
+
+using namespace std;
+
+/* searches how many replicas each compute op gets, any count up to
+ * avail_gpus rather than OpPartitioner's powers of two, and the ring window
+ * MP places them in, for the placement with the smallest
+ * estimate_iter_time( ). Simulated annealing from OpPartitioner's split
+ * counts and d_max, with a fixed seed so a search is reproducible. The
+ * placement includes the syncs with the data-parallel copies of the ring,
+ * avail_gpus apart, so that they are costed too */
+class SearchPlacement : public BasePlacement {
+ private:
+  int avail_gpus;
+  int d_max;
+  Step quant_step;
+  const BWEstimate &bw_est;
+  size_t num_iterations;
+  /* the replicas of each input op in the best placement */
+  OpMap< vector< Op * > > parallel_ops_map;
+
+  /* partitions the input graph into splits_map replicas and places them
+   * with MP within the window; NOT_AVAILABLE if they do not fit */
+  ExitStatus place( const map< Op *, uint32_t > &splits_map,
+                    int window,
+                    CG &output_graph,
+                    OpMap< vector< Op * > > &replicas,
+                    Step &est_steps );
+
+ public:
+  SearchPlacement( BaseInterconnect *interconnect,
+                   GPU *gpus,
+                   uint32_t num_gpus,
+                   const CG &input_graph,
+                   int avail_gpus,
+                   int d_max,
+                   Step quant_step,
+                   const BWEstimate &bw_est,
+                   size_t num_iterations ) : BasePlacement( interconnect, gpus, num_gpus, input_graph ),
+                                             avail_gpus( avail_gpus ),
+                                             d_max( d_max ),
+                                             quant_step( quant_step ),
+                                             bw_est( bw_est ),
+                                             num_iterations( num_iterations ),
+                                             parallel_ops_map( ) { }
+
+ protected:
+  ExitStatus num_batch_splits( Op *op, uint32_t &num_splits ) override;
+
+ public:
+  ExitStatus find_placement( CG &output_graph ) override;
+
+  const OpMap< vector< Op * > > &get_parallel_ops_map( ) const { return parallel_ops_map; }
+};
+
+#endif //SIPML_SRC_PLACEMENT_SEARCH_PLACEMENT_HH_
@@ -1,117 +1,600 @@
 #include "strategy.hh"
 #include "op_partitioner.hh"
+#include "search_placement.hh"
+#include "heft.hh"
+#include <memory>
+#include <set>
+#include <sstream>
 
 ExitStatus Strategy::get_hybrid_placement( const uint32_t dp_degree,
                                            const uint32_t mp_degree,
                                            const uint32_t global_bs,
                                            Step &est_steps,
                                            CG &batch_param_partitioned_graph ){
+  BWEstimate bw_est;
+  interconnect->offline_bw_est( bw_est ).ok( );
+  return place_candidate( input_graph, bw_est, dp_degree, mp_degree, global_bs, est_steps, batch_param_partitioned_graph, cout, nullptr );
+}
+
+ExitStatus Strategy::place_candidate( const CG &graph,
+                                      const BWEstimate &bw_est,
+                                      const uint32_t dp_degree,
+                                      const uint32_t mp_degree,
+                                      const uint32_t global_bs,
+                                      Step &est_steps,
+                                      CG &batch_param_partitioned_graph,
+                                      ostream &out,
+                                      OpMap< vector< Op * > > *parallel_ops_map ){
   uint16_t local_bs;
   local_bs = global_bs / dp_degree;
-  input_graph.set_global_batchsize( local_bs );
-//      input_graph.summary( );
-  cout << "===========================================" << endl;
-  cout << "global_bs=" << global_bs << ", "
-       << "dp_degree=" << dp_degree << ", "
-       << "mp_degree=" << mp_degree << ":"
-       << endl;
-  map< Op *, uint32_t > batch_max_splits;
-  for ( auto e : input_graph.adj ) {
-    batch_max_splits[ e.first ] = mp_degree;
+  graph.set_global_batchsize( local_bs );
+//      graph.summary( );
+  out << "===========================================" << endl;
+  out << "global_bs=" << global_bs << ", "
+      << "dp_degree=" << dp_degree << ", "
+      << "mp_degree=" << mp_degree << ":"
+      << endl;
+  /* MP's placement depends on the interconnect only through the gpus and
+   * their timing, so a cached one is reused and only its estimate redone;
+   * the search and HEFT also go by the bandwidth estimate, which their
+   * entries name */
+  string cache_key;
+  string cache_params;
+  if ( cache != nullptr ) {
+    uint64_t total_mem;
+    gpus[ 0 ].get_total_memsize( total_mem ).ok( );
+    /* placement_version names changes to how MP places, so that older
+     * entries are not reused */
+    cache_params = string( "placement_version=2 " )
+        + "num_gpus=" + to_string( interconnect->num_gpus ) + " "
+        + "dp_degree=" + to_string( dp_degree ) + " "
+        + "mp_degree=" + to_string( mp_degree ) + " "
+        + "global_bs=" + to_string( global_bs ) + " "
+        + "batch_quant_step=" + to_string( batch_quant_step ) + " "
+        + "d_max=" + to_string( d_max ) + " "
+        + "gpu_min_comp_time=" + to_string( cnfg.gpu_min_comp_time ) + " "
+        + "gpu_launch_latency=" + to_string( cnfg.gpu_launch_latency ) + " "
+        + "gpu_mem=" + to_string( total_mem )
+        + ( search_iterations > 0 ? " search_iterations=" + to_string( search_iterations ) : "" )
+        + ( heft && search_iterations == 0 ? " placer=heft" : "" );
+    if ( search_iterations > 0 || heft )
+      cache_params += bw_est_params( bw_est );
+    if ( comm_splits && search_iterations == 0 && heft )
+      cache_params += " splits=comm";
+    else if ( comm_splits && search_iterations == 0 ) {
+      double port_bw;
+      Step transfer_latency;
+      port_bw_est( port_bw, transfer_latency ).ok( );
+      cache_params += " splits=comm port_bw=" + to_string( port_bw ) + " transfer_latency=" + to_string( transfer_latency );
+    }
+    cache->key( graph, cache_params, cache_key ).ok( );
+    auto device_of = [ this ]( DeviceType type, DeviceId dev_id ) -> Device * {
+      if ( type == DeviceType::GPU && dev_id < interconnect->num_gpus )
+        return &gpus[ dev_id ];
+      if ( type == DeviceType::INTERCONNECT && dev_id == interconnect->dev_id )
+        return interconnect;
+      return nullptr;
+    };
+    ExitStatus cached_status;
+    if ( cache->lookup( cache_key, cache_params, device_of, cached_status, batch_param_partitioned_graph ) == ExitStatus::SUCCESS ) {
+      out << "placement cache hit: " << cache_key << endl;
+      if ( cached_status != ExitStatus::SUCCESS ) {
+        cerr << "OOM on gpus." << endl;
+        return ExitStatus::NOT_AVAILABLE;
+      }
+      MP pl( interconnect, gpus, interconnect->num_gpus, graph, { }, mp_degree /* avail_gpus */, d_max );
+      pl.set_calibration( calibration ).ok( );
+      pl.estimate_iter_time( batch_param_partitioned_graph, bw_est, est_steps ).ok( );
+      return ExitStatus::SUCCESS;
+    }
   }
-  OpPartitionerAttribute op_partitioner_batch( batch_quant_step, batch_max_splits, input_graph );
+
+  if ( search_iterations > 0 ) {
+    SearchPlacement pl( interconnect,
+                        gpus,
+                        interconnect->num_gpus,
+                        graph,
+                        mp_degree /* avail_gpus */,
+                        d_max,
+                        batch_quant_step,
+                        bw_est,
+                        search_iterations );
+    pl.set_calibration( calibration ).ok( );
+    const ExitStatus status = pl.find_placement( batch_param_partitioned_graph );
+    if ( cache != nullptr && cache->store( cache_key, cache_params, status,
+                                           status == ExitStatus::SUCCESS ? batch_param_partitioned_graph : CG( )) != ExitStatus::SUCCESS )
+      cerr << "Could not write placement " << cache_key << " to the cache." << endl;
+    if ( status != ExitStatus::SUCCESS ) {
+      cerr << "OOM on gpus." << endl;
+      return ExitStatus::NOT_AVAILABLE;
+    }
+    pl.estimate_iter_time( batch_param_partitioned_graph, bw_est, est_steps ).ok( );
+    return ExitStatus::SUCCESS;
+  }
+
   CG batch_partitioned_graph;
-  map< Op *, vector< Op * > > parallel_batch_ops_map;
-  op_partitioner_batch.partition( batch_partitioned_graph, parallel_batch_ops_map );
-  assert( input_graph.adj.size( ) == parallel_batch_ops_map.size( ));
+  OpMap< vector< Op * > > parallel_batch_ops_map;
+  make_partitioner( graph, mp_degree )->partition( batch_partitioned_graph, parallel_batch_ops_map );
+  assert( graph.adj.size( ) == parallel_batch_ops_map.size( ));
 
   batch_param_partitioned_graph = batch_partitioned_graph;
-  MP pl( interconnect,
-         gpus,
-         interconnect->num_gpus,
-         input_graph,
-         parallel_batch_ops_map,
-         mp_degree /* avail_gpus */,
-         d_max );
-
-  if ( pl.find_placement( batch_param_partitioned_graph ) != ExitStatus::SUCCESS ) {
+  unique_ptr< BasePlacement > pl;
+  if ( heft )
+    pl.reset( new HEFT( interconnect,
+                        gpus,
+                        interconnect->num_gpus,
+                        graph,
+                        parallel_batch_ops_map,
+                        mp_degree /* avail_gpus */,
+                        bw_est ));
+  else
+    pl.reset( new MP( interconnect,
+                      gpus,
+                      interconnect->num_gpus,
+                      graph,
+                      parallel_batch_ops_map,
+                      mp_degree /* avail_gpus */,
+                      d_max ));
+  pl->set_calibration( calibration ).ok( );
+
+  if ( pl->find_placement( batch_param_partitioned_graph ) != ExitStatus::SUCCESS ) {
     cerr << "OOM on gpus." << endl;
     batch_param_partitioned_graph.release_ops( ).ok( );
+    if ( cache != nullptr && cache->store( cache_key, cache_params, ExitStatus::NOT_AVAILABLE, CG( )) != ExitStatus::SUCCESS )
+      cerr << "Could not write placement " << cache_key << " to the cache." << endl;
     return ExitStatus::NOT_AVAILABLE;
   }
-  pl.add_dp_sync_netops( batch_param_partitioned_graph, parallel_batch_ops_map, mp_degree ).ok( );
-  est_steps = 0;
-//  pl.estimate_iter_time( batch_param_partitioned_graph, est_steps );
+  pl->add_dp_sync_netops( batch_param_partitioned_graph, parallel_batch_ops_map, mp_degree ).ok( );
+  if ( cache != nullptr && cache->store( cache_key, cache_params, ExitStatus::SUCCESS, batch_param_partitioned_graph ) != ExitStatus::SUCCESS )
+    cerr << "Could not write placement " << cache_key << " to the cache." << endl;
+  pl->estimate_iter_time( batch_param_partitioned_graph, bw_est, est_steps ).ok( );
+  if ( parallel_ops_map != nullptr )
+    *parallel_ops_map = parallel_batch_ops_map;
 
   return ExitStatus::SUCCESS;
 }
 
-ExitStatus Strategy::optimize_batchsize( CG &best_graph ) {
-  double best_time = std::numeric_limits< double >::max( );
-  Step best_itertime;
-  uint32_t best_dp_degree, best_mp_degree, best_global_bs, best_niter;
+struct Strategy::PlacementTemplate {
+  /* re-batched for each batch size; owns its ops */
+  CG input_graph{ };
+  /* the replicas of each op of input_graph */
+  OpMap< vector< Op * > > parallel_ops_map{ };
+  /* owns its ops, re-costed in place and cloned for each batch size */
+  CG placed{ };
+  uint32_t global_bs = 0;
+
+  void release( ) {
+    input_graph.release_ops( ).ok( );
+    placed.release_ops( ).ok( );
+    parallel_ops_map.clear( );
+  }
+};
 
+ExitStatus Strategy::recost_template( PlacementTemplate &tmpl, const uint32_t mp_degree, const uint16_t local_bs ) {
+  tmpl.input_graph.set_global_batchsize( local_bs ).ok( );
+  map< Op *, uint32_t > splits_map;
+  make_partitioner( tmpl.input_graph, mp_degree )->get_nsplits_all( splits_map ).ok( );
+  for ( auto &e : tmpl.parallel_ops_map ) {
+    if ( splits_map.at( e.first ) != e.second.size( ))
+      return ExitStatus::NOT_AVAILABLE;
+  }
+
+  /* the replicas, as OpPartitionerAttribute::create_parallel_ops( ) costs them */
+  vector< uint64_t > used_memory( interconnect->num_gpus, 0 );
+  for ( auto &e : tmpl.parallel_ops_map ) {
+    if ( e.first->type == OpType::COMPUTE ) {
+      CompOp *comp_op = static_cast< CompOp * >( e.first );
+      uint16_t bs;
+      comp_op->get_batch_size( bs ).ok( );
+      for ( auto rep_op : e.second ) {
+        static_cast< CompOp * >( rep_op )->set_batch_size( bs ).ok( );
+        comp_op->copy_scale_to( static_cast< CompOp * >( rep_op ), 1. / double( e.second.size( )));
+      }
+    }
+    for ( auto rep_op : e.second ) {
+      if ( rep_op->device == nullptr || rep_op->device->type != DeviceType::GPU )
+        continue;
+      uint64_t mem_size;
+      rep_op->get_mem_size( mem_size ).ok( );
+      used_memory.at( rep_op->device->dev_id ) += mem_size;
+    }
+  }
+  uint64_t total_mem;
+  gpus[ 0 ].get_total_memsize( total_mem ).ok( );
+  for ( auto used : used_memory ) {
+    if ( used > total_mem )
+      return ExitStatus::NOT_AVAILABLE;
+  }
+
+  /* the copies of compute outputs; the rest move parameters and do not
+   * depend on the batch size */
+  set< pair< Op *, Op * > > copied;
+  for ( auto &e : tmpl.placed.adj ) {
+    if ( e.first->type != OpType::NETWORK || e.second.size( ) != 1 )
+      continue;
+    auto &preds = tmpl.placed.reverse_adj.at( e.first );
+    if ( preds.size( ) != 1 || ( *preds.begin( ))->type != OpType::COMPUTE )
+      continue;
+    Op *src_op = *preds.begin( );
+    Op *dst_op = *e.second.begin( );
+    uint32_t num_transfer_bytes;
+    BasePlacement::async_transfer_bytes( src_op, dst_op, num_transfer_bytes ).ok( );
+    if ( num_transfer_bytes == 0 )
+      return ExitStatus::NOT_AVAILABLE;
+    static_cast< NetOp * >( e.first )->transfer_bytes = num_transfer_bytes;
+    copied.insert( make_pair( src_op, dst_op ));
+  }
+  /* an output that was empty before, and so never copied */
+  for ( auto &e : tmpl.placed.adj ) {
+    Op *src_op = e.first;
+    if ( src_op->type != OpType::COMPUTE || src_op->device->type != DeviceType::GPU )
+      continue;
+    for ( auto dst_op : e.second ) {
+      if ( dst_op->device == src_op->device || dst_op->device->type != DeviceType::GPU
+          || ( dst_op->type != OpType::COMPUTE && dst_op->type != OpType::MEMORY )
+          || copied.count( make_pair( src_op, dst_op )) > 0 )
+        continue;
+      uint32_t num_transfer_bytes;
+      BasePlacement::async_transfer_bytes( src_op, dst_op, num_transfer_bytes ).ok( );
+      if ( num_transfer_bytes > 0 )
+        return ExitStatus::NOT_AVAILABLE;
+    }
+  }
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Strategy::place_incremental( PlacementTemplate &tmpl,
+                                        const BWEstimate &bw_est,
+                                        const uint32_t dp_degree,
+                                        const uint32_t mp_degree,
+                                        const uint32_t global_bs,
+                                        Step &est_steps,
+                                        CG &batch_param_partitioned_graph,
+                                        ostream &out ) {
+  if ( ! tmpl.placed.adj.empty( )) {
+    if ( recost_template( tmpl, mp_degree, global_bs / dp_degree ) == ExitStatus::SUCCESS ) {
+      out << "===========================================" << endl;
+      out << "global_bs=" << global_bs << ", "
+          << "dp_degree=" << dp_degree << ", "
+          << "mp_degree=" << mp_degree << ":"
+          << endl;
+      out << "re-costed the placement of global_bs=" << tmpl.global_bs << endl;
+      tmpl.placed.clone( batch_param_partitioned_graph ).ok( );
+      MP pl( interconnect, gpus, interconnect->num_gpus, tmpl.input_graph, { }, mp_degree /* avail_gpus */, d_max );
+      pl.set_calibration( calibration ).ok( );
+      pl.estimate_iter_time( batch_param_partitioned_graph, bw_est, est_steps ).ok( );
+      return ExitStatus::SUCCESS;
+    }
+    tmpl.release( );
+  }
+
+  CG graph;
+  input_graph.clone( graph ).ok( );
+  CG placed;
+  OpMap< vector< Op * > > parallel_ops_map;
+  const ExitStatus status = place_candidate( graph,
+                                             bw_est,
+                                             dp_degree,
+                                             mp_degree,
+                                             global_bs,
+                                             est_steps,
+                                             placed,
+                                             out,
+                                             &parallel_ops_map );
+  /* a cached placement has no replica map to re-cost */
+  if ( status != ExitStatus::SUCCESS || parallel_ops_map.empty( )) {
+    graph.release_ops( ).ok( );
+    batch_param_partitioned_graph = placed;
+    return status;
+  }
+  tmpl.input_graph = graph;
+  tmpl.parallel_ops_map = parallel_ops_map;
+  tmpl.placed = placed;
+  tmpl.global_bs = global_bs;
+  tmpl.placed.clone( batch_param_partitioned_graph ).ok( );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Strategy::set_num_threads( size_t num_threads ) {
+  delete pool;
+  pool = ( num_threads > 1 ? new WorkerPool( num_threads ) : nullptr );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Strategy::set_cache_dir( const string &cache_dir ) {
+  delete cache;
+  cache = new PlacementCache( cache_dir );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Strategy::set_calibration( const EstimatorCalibration &estimator_calibration ) {
+  calibration = estimator_calibration;
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Strategy::set_incremental( const bool incremental_placement ) {
+  incremental = incremental_placement;
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Strategy::set_search_iterations( const size_t num_iterations ) {
+  search_iterations = num_iterations;
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Strategy::set_heft( const bool heft_placement ) {
+  heft = heft_placement;
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Strategy::set_comm_splits( const bool comm_aware_splits ) {
+  comm_splits = comm_aware_splits;
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Strategy::port_bw_est( double &port_bw, Step &transfer_latency ) const {
+  double tx_bw, rx_bw;
+  interconnect->offline_port_bw_est( tx_bw, rx_bw ).ok( );
+  port_bw = min( tx_bw, rx_bw ) * calibration.bw_efficiency;
+  transfer_latency = cnfg.interconnect_latency + Step( calibration.net_overhead_sec / cnfg.step_size_sec + 0.5 );
+  return ExitStatus::SUCCESS;
+}
+
+string Strategy::bw_est_params( const BWEstimate &bw_est ) const {
+  vector< double > pair_bw;
+  for ( DeviceId i = 0; i < interconnect->num_gpus; i ++ ) {
+    auto row = bw_est.find( &gpus[ i ] );
+    for ( DeviceId j = 0; j < interconnect->num_gpus; j ++ ) {
+      if ( row == bw_est.end( ) || row->second.count( &gpus[ j ] ) == 0 )
+        pair_bw.push_back( - 1 );
+      else
+        pair_bw.push_back( row->second.at( &gpus[ j ] ));
+    }
+  }
+  double port_bw;
+  Step transfer_latency;
+  port_bw_est( port_bw, transfer_latency ).ok( );
+  return " bw_est=" + PlacementCache::digest( pair_bw )
+      + " port_bw=" + to_string( port_bw )
+      + " transfer_latency=" + to_string( transfer_latency )
+      + " bw_efficiency=" + to_string( calibration.bw_efficiency );
+}
+
+unique_ptr< OpPartitioner > Strategy::make_partitioner( const CG &graph, const uint32_t mp_degree ) const {
+  map< Op *, uint32_t > batch_max_splits;
+  for ( auto e : graph.adj ) {
+    batch_max_splits[ e.first ] = mp_degree;
+  }
+  if ( ! comm_splits )
+    return unique_ptr< OpPartitioner >( new OpPartitionerAttribute( batch_quant_step, batch_max_splits, graph ));
+  double port_bw;
+  Step transfer_latency;
+  port_bw_est( port_bw, transfer_latency ).ok( );
+  return unique_ptr< OpPartitioner >( new OpPartitionerComm( batch_quant_step, batch_max_splits, graph, port_bw, transfer_latency ));
+}
+
+struct Strategy::Candidate {
+  uint32_t global_bs;
+  uint32_t niter;
+  uint32_t dp_degree;
+  uint32_t mp_degree;
+  Step est_steps;
+  double time_to_acc; /* minutes, at est_steps per iteration */
+  ExitStatus status;
+  CG graph;
+  ostringstream out;
+
+  Candidate( uint32_t global_bs, uint32_t niter, uint32_t dp_degree, uint32_t mp_degree )
+      : global_bs( global_bs ), niter( niter ), dp_degree( dp_degree ), mp_degree( mp_degree ),
+        est_steps( 0 ), time_to_acc( 0 ), status( ExitStatus::SUCCESS ), graph( ), out( ) { }
+};
+
+ExitStatus Strategy::rank_candidates( const size_t top_k, vector< unique_ptr< Candidate > > &ranked ) {
   uint32_t dp_degree;
   uint32_t mp_degree;
 
   auto n_gpus = interconnect->num_gpus;
+  BWEstimate bw_est;
+  interconnect->offline_bw_est( bw_est ).ok( );
+  vector< unique_ptr< Candidate > > candidates;
   for ( auto bs_niter : batchsize_to_niter ) {
     auto global_bs = bs_niter.first;
     auto niter = bs_niter.second;
+    /* the search places any mp_degree, so every dp_degree that splits
+     * both the gpus and the batch evenly is tried */
+    if ( search_iterations > 0 ) {
+      for ( dp_degree = 1; dp_degree <= n_gpus && dp_degree <= global_bs; dp_degree ++ ) {
+        if ( n_gpus % dp_degree == 0 && global_bs % dp_degree == 0 )
+          candidates.emplace_back( new Candidate( global_bs, niter, dp_degree, n_gpus / dp_degree ));
+      }
+      continue;
+    }
     dp_degree = 1;
     for ( int i = 0; i <= log2( n_gpus ); i ++ ) {
       if ( dp_degree > global_bs )
         break;
 
       mp_degree = interconnect->num_gpus / dp_degree;
-      Step est_steps;
-      CG batch_param_partitioned_graph;
-      ExitStatus is_ok = get_hybrid_placement( dp_degree,
-                            mp_degree,
-                            global_bs,
-                            est_steps,
-                            batch_param_partitioned_graph );
-      if ( is_ok == ExitStatus::NOT_AVAILABLE ){
-        continue;
+      candidates.emplace_back( new Candidate( global_bs, niter, dp_degree, mp_degree ));
+      dp_degree = dp_degree << 1;
+//      if ( dp_degree == 128 )
+//        break;
+    }
+  }
+
+  /* each candidate re-batches and places its own copy of the input graph,
+   * so the candidates of a wave are placed concurrently; going through the
+   * waves in order keeps the output, and the choice among equally good
+   * candidates, the same as one by one, and bounds how many placed graphs
+   * are held at once. Incrementally, the candidates of a dp_degree share
+   * its template, so a wave holds at most one of them */
+  map< uint32_t, PlacementTemplate > templates;
+  if ( incremental ) {
+    for ( auto &cand : candidates )
+      templates[ cand->dp_degree ];
+  }
+  const size_t wave_size = ( pool == nullptr ? 1 : pool->size( ));
+  size_t wave_end;
+  for ( size_t wave = 0; wave < candidates.size( ); wave = wave_end ) {
+    set< uint32_t > wave_dp_degrees;
+    for ( wave_end = wave; wave_end < candidates.size( ) && wave_end - wave < wave_size; wave_end ++ ) {
+      if ( incremental && ! wave_dp_degrees.insert( candidates[ wave_end ]->dp_degree ).second )
+        break;
+    }
+    auto place = [ this, &bw_est, &candidates, &templates, wave, wave_end ]( size_t part ) {
+      if ( wave + part >= wave_end )
+        return;
+      Candidate &cand = *candidates[ wave + part ];
+      if ( incremental ) {
+        cand.status = place_incremental( templates.at( cand.dp_degree ),
+                                         bw_est,
+                                         cand.dp_degree,
+                                         cand.mp_degree,
+                                         cand.global_bs,
+                                         cand.est_steps,
+                                         cand.graph,
+                                         cand.out );
+        return;
       }
-//      batch_param_partitioned_graph.summary( );
-      double total_time_minutes = double( est_steps ) * double( niter ) * cnfg.step_size_sec / 60.0;
-      if ( total_time_minutes < best_time ) {
-        best_time = total_time_minutes;
-        best_graph = batch_param_partitioned_graph;
-        best_dp_degree = dp_degree;
-        best_mp_degree = mp_degree;
-        best_global_bs = global_bs;
-        best_itertime = est_steps;
-        best_niter = niter;
-      } else {
-        batch_param_partitioned_graph.release_ops( ).ok( );
+      CG graph;
+      input_graph.clone( graph ).ok( );
+      cand.status = place_candidate( graph,
+                                     bw_est,
+                                     cand.dp_degree,
+                                     cand.mp_degree,
+                                     cand.global_bs,
+                                     cand.est_steps,
+                                     cand.graph,
+                                     cand.out,
+                                     nullptr );
+      graph.release_ops( ).ok( );
+    };
+    if ( pool == nullptr )
+      place( 0 );
+    else
+      pool->run( place );
+
+    for ( size_t c = wave; c < wave_end; c ++ ) {
+      Candidate &cand = *candidates[ c ];
+      cout << cand.out.str( );
+      if ( cand.status == ExitStatus::NOT_AVAILABLE ){
+        continue;
       }
-      cout << "est_iter_time=" << est_steps * cnfg.step_size_sec * 1e+3 << "ms, "
-           << "time_to_acc=" << total_time_minutes << " mins."
+//      cand.graph.summary( );
+      cand.time_to_acc = double( cand.est_steps ) * double( cand.niter ) * cnfg.step_size_sec / 60.0;
+      cout << "est_iter_time=" << cand.est_steps * cnfg.step_size_sec * 1e+3 << "ms, "
+           << "time_to_acc=" << cand.time_to_acc << " mins."
            << std::endl;
-      log << "global_bs=" << global_bs << " "
-          << "dp_degree=" << dp_degree << " "
-          << "mp_degree=" << mp_degree << " "
-          << "est_steps=" << est_steps << " "
-          << "total_time_minutes=" << total_time_minutes << " "
+      log << "global_bs=" << cand.global_bs << " "
+          << "dp_degree=" << cand.dp_degree << " "
+          << "mp_degree=" << cand.mp_degree << " "
+          << "est_steps=" << cand.est_steps << " "
+          << "total_time_minutes=" << cand.time_to_acc << " "
           << std::endl;
-//      }
-      dp_degree = dp_degree << 1;
-//      if ( dp_degree == 128 )
-//        break;
+
+      /* after the equally good ones, so earlier candidates win ties */
+      auto pos = upper_bound( ranked.begin( ), ranked.end( ), cand.time_to_acc,
+                              []( double time_to_acc, const unique_ptr< Candidate > &other ) {
+                                return time_to_acc < other->time_to_acc;
+                              } );
+      if ( pos == ranked.end( ) && ranked.size( ) >= top_k ) {
+        cand.graph.release_ops( ).ok( );
+        continue;
+      }
+      ranked.insert( pos, std::move( candidates[ c ] ));
+      if ( ranked.size( ) > top_k ) {
+        ranked.back( )->graph.release_ops( ).ok( );
+        ranked.pop_back( );
+      }
     }
   }
-  std::cout << "best_global_bs=" << best_global_bs << " "
-            << "best_dp_degree=" << best_dp_degree << " "
-            << "best_mp_degree=" << best_mp_degree << " "
-            << "best_itertime=" << best_itertime << " "
-            << "best_niter=" << best_niter << " "
-            << "best_time=" << best_time << " "
+  for ( auto &e : templates )
+    e.second.release( );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus Strategy::optimize_batchsize( CG &best_graph ) {
+  vector< unique_ptr< Candidate > > ranked;
+  rank_candidates( 1, ranked ).ok( );
+  if ( ranked.empty( )) {
+    cerr << "No strategy fits on the gpus." << endl;
+    return ExitStatus::NOT_AVAILABLE;
+  }
+  const Candidate &best = *ranked.front( );
+  best_graph = best.graph;
+  std::cout << "best_global_bs=" << best.global_bs << " "
+            << "best_dp_degree=" << best.dp_degree << " "
+            << "best_mp_degree=" << best.mp_degree << " "
+            << "best_itertime=" << best.est_steps << " "
+            << "best_niter=" << best.niter << " "
+            << "best_time=" << best.time_to_acc << " "
             << std::endl;
 
   return ExitStatus::SUCCESS;
 }
 
+ExitStatus Strategy::optimize_batchsize( CG &best_graph, const size_t top_k, const CandidateSimulator &simulate ) {
+  vector< unique_ptr< Candidate > > ranked;
+  rank_candidates( max< size_t >( top_k, 1 ), ranked ).ok( );
+  if ( ranked.empty( )) {
+    cerr << "No strategy fits on the gpus." << endl;
+    return ExitStatus::NOT_AVAILABLE;
+  }
+
+  Candidate *best = nullptr;
+  Step best_sim_steps = 0;
+  for ( auto &cand : ranked ) {
+    /* a candidate is only kept if its pass, times its niter, beats the
+     * best one simulated so far, so its simulation is cut off as soon as
+     * it no longer can */
+    Step max_steps = std::numeric_limits< Step >::max( );
+    if ( best != nullptr ) {
+      const uint64_t best_total = uint64_t( best_sim_steps ) * best->niter;
+      max_steps = Step( min< uint64_t >( best_total == 0 ? 0 : ( best_total - 1 ) / cand->niter + 1, max_steps ));
+    }
+    Step sim_steps = 0;
+    const ExitStatus status = simulate( cand->graph, max_steps, sim_steps );
+    cout << "global_bs=" << cand->global_bs << ", "
+         << "dp_degree=" << cand->dp_degree << ", "
+         << "mp_degree=" << cand->mp_degree << ": "
+         << "est_iter_time=" << cand->est_steps * cnfg.step_size_sec * 1e+3 << "ms, ";
+    if ( status != ExitStatus::SUCCESS ) {
+      if ( best == nullptr )
+        cout << "did not finish." << endl;
+      else
+        cout << "cut off at " << max_steps * cnfg.step_size_sec * 1e+3 << "ms." << endl;
+      continue;
+    }
+    cout << "sim_iter_time=" << sim_steps * cnfg.step_size_sec * 1e+3 << "ms, "
+         << "time_to_acc=" << double( sim_steps ) * double( cand->niter ) * cnfg.step_size_sec / 60.0 << " mins."
+         << endl;
+    log << "global_bs=" << cand->global_bs << " "
+        << "dp_degree=" << cand->dp_degree << " "
+        << "mp_degree=" << cand->mp_degree << " "
+        << "est_steps=" << cand->est_steps << " "
+        << "sim_steps=" << sim_steps << " "
+        << std::endl;
+    best = cand.get( );
+    best_sim_steps = sim_steps;
+  }
+  if ( best == nullptr ) {
+    cerr << "No candidate finished its simulated pass, keeping the best estimate." << endl;
+    best = ranked.front( ).get( );
+    best_sim_steps = best->est_steps;
+  }
 
+  for ( auto &cand : ranked ) {
+    if ( cand.get( ) != best )
+      cand->graph.release_ops( ).ok( );
+  }
+  best_graph = best->graph;
+  std::cout << "best_global_bs=" << best->global_bs << " "
+            << "best_dp_degree=" << best->dp_degree << " "
+            << "best_mp_degree=" << best->mp_degree << " "
+            << "best_itertime=" << best_sim_steps << " "
+            << "best_niter=" << best->niter << " "
+            << "best_time=" << double( best_sim_steps ) * double( best->niter ) * cnfg.step_size_sec / 60.0 << " "
+            << std::endl;
 
+  return ExitStatus::SUCCESS;
+}
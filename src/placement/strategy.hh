@@ -1,15 +1,31 @@
 #ifndef SIPML_SRC_PLACEMENT_STRATEGY_HH_
 #define SIPML_SRC_PLACEMENT_STRATEGY_HH_
 #include <utility>
+#include <functional>
+#include <memory>
 #include <math.h>
 #include "exit_status.hh"
 #include "op.hh"
 #include "graph.hh"
 #include "interconnect.hh"
 #include "mp.hh"
+#include "op_partitioner.hh"
+#include "placement_cache.hh"
+#include "worker_pool.hh"
 
 class Strategy {
+ public:
+  /* simulates graph for at most max_steps steps; num_steps is the step its
+   * pass finished at, and NOT_AVAILABLE means it did not finish by then */
+  using CandidateSimulator = std::function< ExitStatus( const CG &graph, Step max_steps, Step &num_steps ) >;
+
  private:
+  /* one ( global_bs, dp_degree ) point of optimize_batchsize( ) */
+  struct Candidate;
+  /* the placement of a ( dp_degree, mp_degree ) that the next batch sizes
+   * are re-costed on, see place_incremental( ) */
+  struct PlacementTemplate;
+
   const CG input_graph;
   BaseInterconnect *interconnect;
   const std::map< uint32_t, uint32_t > batchsize_to_niter;
@@ -19,6 +35,19 @@ class Strategy {
   SimConfig cnfg;
   const string log_dir;
   ofstream log;
+  /* evaluates the candidates of optimize_batchsize( ) concurrently */
+  WorkerPool *pool;
+  /* placements of earlier runs, or nullptr */
+  PlacementCache *cache;
+  EstimatorCalibration calibration;
+  /* re-cost one placement per ( dp_degree, mp_degree ) across the batch sizes */
+  bool incremental;
+  /* moves of each SearchPlacement, or 0 to place with MP as is */
+  size_t search_iterations;
+  /* place with HEFT instead of MP, unless searching */
+  bool heft;
+  /* partition with OpPartitionerComm rather than OpPartitionerAttribute */
+  bool comm_splits;
  public:
   Strategy( const CG &input_graph,
             BaseInterconnect *interconnect,
@@ -32,12 +61,42 @@ class Strategy {
         interconnect( interconnect ),
         batchsize_to_niter( std::move( batchsize_to_niter )),
         batch_quant_step( batch_quant_step ),
-        gpus( gpus ), d_max( d_max ), cnfg( cnfg ), log_dir( log_dir ), log( ) {
+        gpus( gpus ), d_max( d_max ), cnfg( cnfg ), log_dir( log_dir ), log( ), pool( nullptr ), cache( nullptr ), calibration( ), incremental( false ), search_iterations( 0 ), heft( false ), comm_splits( false ) {
     log = std::ofstream( log_dir + "strategy.log", std::ofstream::out );
   }
 
   ExitStatus optimize_batchsize( CG &best_graph );
 
+  /* ranks the candidates by their estimated time-to-accuracy, simulates
+   * the top_k of them and keeps the one with the best simulated
+   * time-to-accuracy */
+  ExitStatus optimize_batchsize( CG &best_graph, size_t top_k, const CandidateSimulator &simulate );
+
+  /* number of candidates optimize_batchsize( ) places at once */
+  ExitStatus set_num_threads( size_t num_threads );
+
+  /* reuse, and keep, the placements in cache_dir */
+  ExitStatus set_cache_dir( const string &cache_dir );
+
+  /* corrects the iteration-time estimates the candidates are ranked by */
+  ExitStatus set_calibration( const EstimatorCalibration &estimator_calibration );
+
+  /* place each ( dp_degree, mp_degree ) once and re-cost that placement at
+   * the other batch sizes, as long as it still partitions the same and
+   * fits in memory */
+  ExitStatus set_incremental( bool incremental_placement );
+
+  /* place with a SearchPlacement of num_iterations moves, which also
+   * lets optimize_batchsize( ) try every dp_degree dividing the gpus */
+  ExitStatus set_search_iterations( size_t num_iterations );
+
+  /* place each candidate by HEFT list scheduling rather than MP */
+  ExitStatus set_heft( bool heft_placement );
+
+  /* split each op only as far as its compute speedup pays for the
+   * transfers the split causes over the interconnect */
+  ExitStatus set_comm_splits( bool comm_aware_splits );
+
   ExitStatus get_hybrid_placement( uint32_t dp_degree,
                                    uint32_t mp_degree,
                                    uint32_t global_bs,
@@ -53,9 +112,54 @@ class Strategy {
  private:
   ExitStatus scale_input_graph( CG &scaled_input_graph, const double &batch_factor );
 
+  /* the partitioner of graph into at most mp_degree replicas per op */
+  std::unique_ptr< OpPartitioner > make_partitioner( const CG &graph, uint32_t mp_degree ) const;
+
+  /* the gpu port bandwidth, in bytes per step, and per-transfer latency,
+   * in steps, that estimate_iter_time( ) goes by */
+  ExitStatus port_bw_est( double &port_bw, Step &transfer_latency ) const;
+
+  /* the cache params naming what a placement searched by its estimate
+   * reads of the interconnect: bw_est, the port bandwidth and the
+   * calibration */
+  std::string bw_est_params( const BWEstimate &bw_est ) const;
+
+  /* get_hybrid_placement( ) of graph, which it re-batches, reporting to out;
+   * a fresh placement also fills parallel_ops_map, unless it is nullptr */
+  ExitStatus place_candidate( const CG &graph,
+                              const BWEstimate &bw_est,
+                              uint32_t dp_degree,
+                              uint32_t mp_degree,
+                              uint32_t global_bs,
+                              Step &est_steps,
+                              CG &batch_param_partitioned_graph,
+                              ostream &out,
+                              OpMap< vector< Op * > > *parallel_ops_map );
+
+  /* place_candidate( ) of the input graph by re-costing tmpl, or by a
+   * fresh placement that then becomes tmpl */
+  ExitStatus place_incremental( PlacementTemplate &tmpl,
+                                const BWEstimate &bw_est,
+                                uint32_t dp_degree,
+                                uint32_t mp_degree,
+                                uint32_t global_bs,
+                                Step &est_steps,
+                                CG &batch_param_partitioned_graph,
+                                ostream &out );
+
+  /* re-costs the placed ops of tmpl at local_bs; NOT_AVAILABLE if a fresh
+   * placement would partition differently or a gpu runs out of memory */
+  ExitStatus recost_template( PlacementTemplate &tmpl, uint32_t mp_degree, uint16_t local_bs );
+
+  /* places every candidate and keeps the top_k by estimated
+   * time-to-accuracy in ranked, best first */
+  ExitStatus rank_candidates( size_t top_k, std::vector< std::unique_ptr< Candidate > > &ranked );
+
  public:
   ~Strategy( ) {
     log.close( );
+    delete pool;
+    delete cache;
   }
   Strategy(const Strategy&) = delete;
 
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cstdint>
+#include <memory>
 #include <assert.h>
 #include <sys/stat.h>
 #include "matrix.hh"
@@ -9,6 +10,7 @@
 #include "interconnect.hh"
 #include "gpu.hh"
 #include "session.hh"
+#include "simulation.hh"
 #include "graph.hh"
 #include "placement.hh"
 #include "strategy.hh"
@@ -18,16 +20,7 @@
 
 using namespace std;
 
-uint16_t GPU::dev_count = 0;
-
 const uint16_t Packet::max_pkt_size = 1504; /* bytes */
-uint64_t Packet::num_pkts = 0;
-
-Step Device::curr_step = 0;
-
-NetworkSignal GPU::recv_sig = { };
-
-std::unordered_map< PacketId, Packet * > Transport::flying_pkts = { };
 
 static struct option command_line_options[] = {
     { "num_gpus", required_argument, nullptr, 'g' },
@@ -38,6 +31,16 @@ static struct option command_line_options[] = {
     { "log_dir", required_argument, nullptr, 'l' },
     { "num_profiles", required_argument, nullptr, 'n' },
     { "step_size_sec", required_argument, nullptr, 't' },
+    { "pipelined", no_argument, nullptr, 'P' },
+    { "windowed", no_argument, nullptr, 'W' },
+    { "threads", required_argument, nullptr, 'T' },
+    { "top_k", required_argument, nullptr, 'k' },
+    { "cache_dir", required_argument, nullptr, 'c' },
+    { "estimator_calibration", required_argument, nullptr, 'e' },
+    { "incremental", no_argument, nullptr, 'r' },
+    { "search", required_argument, nullptr, 'S' },
+    { "heft", no_argument, nullptr, 'H' },
+    { "comm_splits", no_argument, nullptr, 'C' },
     { "help", no_argument, nullptr, 'h' },
     { 0, 0, 0, 0 }
 };
@@ -49,15 +52,27 @@ void usage( const char *argv0 ) {
        << " [-d,--latency_us LATENCY_MICROSECOND ]"
        << " [-t,--step_size_sec STEP_SIZE_SEC ]"
        << " [-i,--input_profile INPUT_PROFILE] [-l,--log_dir LOG_DIR]" << endl
+       << " [-P,--pipelined | -W,--windowed] [-T,--threads NUM_THREADS]"
+       << " [-k,--top_k TOP_K] [-c,--cache_dir CACHE_DIR]"
+       << " [-e,--estimator_calibration CALIBRATION_FILE] [-r,--incremental] [-S,--search ITERATIONS] [-H,--heft] [-C,--comm_splits]"
        << endl;
 }
 
 int main( int argc, char **argv ) {
-  uint16_t num_gpus = 0;
+  DeviceId num_gpus = 0;
   double bw_per_port_Gb = 0;
   uint32_t latency_us = 1;
   string input_profile;
   string log_dir;
+  SimMode mode = SimMode::SERIAL;
+  size_t num_threads = 1;
+  size_t top_k = 0;
+  string cache_dir;
+  string calibration_file;
+  bool incremental = false;
+  size_t search_iterations = 0;
+  bool heft = false;
+  bool comm_splits = false;
   bool is_auto_strategy = true;
   uint32_t dp_degree;
   uint32_t mp_degree;
@@ -69,7 +84,7 @@ int main( int argc, char **argv ) {
     /* getopt_long stores the option index here. */
     int option_index = 0;
 
-    const int opt = getopt_long( argc, argv, "g:b:d:s:i:l:n:t:h", command_line_options, &option_index );
+    const int opt = getopt_long( argc, argv, "g:b:d:s:i:l:n:t:PWT:k:c:e:rS:HCh", command_line_options, &option_index );
 
     /* Detect the end of the options. */
     if ( opt == - 1 )
@@ -107,6 +122,26 @@ int main( int argc, char **argv ) {
         break;
       case 't': step_size_sec = stod( optarg );
         break;
+      case 'P': mode = SimMode::PIPELINED;
+        break;
+      case 'W': mode = SimMode::WINDOWED;
+        break;
+      case 'T': num_threads = stoul( optarg );
+        break;
+      case 'k': top_k = stoul( optarg );
+        break;
+      case 'c': cache_dir = optarg;
+        break;
+      case 'e': calibration_file = optarg;
+        break;
+      case 'r': incremental = true;
+        break;
+      case 'S': search_iterations = stoul( optarg );
+        break;
+      case 'H': heft = true;
+        break;
+      case 'C': comm_splits = true;
+        break;
       case 'h': usage( argv[ 0 ] );
         return EXIT_SUCCESS;
         break;
@@ -151,10 +186,12 @@ int main( int argc, char **argv ) {
   cnfg.summary( );
 
   /* create gpus */
+  SimContext ctx;
   auto gpus = new GPU[num_gpus];
-  for ( int i = 0; i < num_gpus; i ++ ) {
+  for ( DeviceId i = 0; i < num_gpus; i ++ ) {
     gpus[ i ].cnfg = &cnfg;
-    gpus[ i ].setup_transport( num_gpus );
+    gpus[ i ].join( ctx ).ok( );
+    gpus[ i ].setup_transport( );
   }
 
 
@@ -191,8 +228,38 @@ int main( int argc, char **argv ) {
                      num_gpus /* max_dist */,
                      cnfg,
                      log_dir );
+  strategy.set_num_threads( num_threads ).ok( );
+  strategy.set_incremental( incremental ).ok( );
+  strategy.set_search_iterations( search_iterations ).ok( );
+  strategy.set_heft( heft ).ok( );
+  strategy.set_comm_splits( comm_splits ).ok( );
+  if ( ! cache_dir.empty( )) {
+    if ( system( ( "mkdir -p " + cache_dir ).c_str( )) == - 1 )
+      cerr << "Error :  " << strerror(errno) << endl;
+    strategy.set_cache_dir( cache_dir ).ok( );
+  }
+  if ( ! calibration_file.empty( )) {
+    EstimatorCalibration calibration;
+    if ( EstimatorCalibration::load( calibration_file, cnfg.inter_type, calibration ) == ExitStatus::SUCCESS )
+      strategy.set_calibration( calibration ).ok( );
+    else
+      cerr << "No " << EstimatorCalibration::topology_name( cnfg.inter_type ) << " calibration in " << calibration_file << endl;
+  }
+
+  /* with a top_k, the best estimated strategies are simulated, each on its
+   * own copy of the cluster logging to LOG_DIR/top_k/ */
+  const string top_k_log_dir = log_dir + "top_k/";
+  const InterconnectFactory factory = electrical_switch_factory( bw_per_port_bytes );
+  auto simulate = [ & ]( const CG &candidate, Step max_steps, Step &num_steps ) {
+    return simulate_copy( candidate, num_gpus, cnfg, factory, min< uint64_t >( max_steps, MAX_NUM_ITERATIONS ), mode, top_k_log_dir, num_steps );
+  };
+  if ( top_k > 0 && system( ( "mkdir -p " + top_k_log_dir ).c_str( )) == - 1 )
+    cerr << "Error :  " << strerror(errno) << endl;
+
   CG final_graph;
-  if ( is_auto_strategy )
+  if ( is_auto_strategy && top_k > 0 )
+    strategy.optimize_batchsize( final_graph, top_k, simulate ).ok( );
+  else if ( is_auto_strategy )
     strategy.optimize_batchsize( final_graph ).ok( );
   else {
     Step est_steps;
@@ -208,14 +275,8 @@ int main( int argc, char **argv ) {
   SingleShotEsimator single_shot_esimator( num_gpus, log_dir );
   single_shot_esimator.bind_to_sessions( &session, 1 );
   single_shot_esimator.log( );
-  bool done = false;
-  for ( int it = 0; it < MAX_NUM_ITERATIONS; it ++ ) {
-    session.proceed( done ).ok( );
-    if ( done )
-      break;
-    interconnect.proceed( ).ok( );
-    Device::curr_step ++;
-  }
+  interconnect.set_num_threads( num_threads ).ok( );
+  run_simulation( session, interconnect, MAX_NUM_ITERATIONS, mode ).ok( );
   delete[] gpus;
   return 0;
 }
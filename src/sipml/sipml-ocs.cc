@@ -2,12 +2,14 @@
 #include <iostream>
 #include <iomanip>
 #include <cstdint>
+#include <memory>
 #include <assert.h>
 #include <sys/stat.h>
 #include "sim_config.hh"
 #include "interconnect.hh"
 #include "gpu.hh"
 #include "session.hh"
+#include "simulation.hh"
 #include "graph.hh"
 #include "placement.hh"
 #include "strategy.hh"
@@ -15,16 +17,7 @@
 
 using namespace std;
 
-uint16_t GPU::dev_count = 0;
-
 const uint16_t Packet::max_pkt_size = 1504; /* bytes */
-uint64_t Packet::num_pkts = 0;
-
-Step Device::curr_step = 0;
-
-NetworkSignal GPU::recv_sig = { };
-
-std::unordered_map< PacketId, Packet * > Transport::flying_pkts = { };
 
 static struct option command_line_options[] = {
     { "num_gpus", required_argument, nullptr, 'g' },
@@ -39,6 +32,16 @@ static struct option command_line_options[] = {
     { "single_shot", no_argument, nullptr, 's' },
     { "strategy", required_argument, nullptr, 't' },
     { "step_size_sec", required_argument, nullptr, 'z' },
+    { "pipelined", no_argument, nullptr, 'P' },
+    { "windowed", no_argument, nullptr, 'W' },
+    { "threads", required_argument, nullptr, 'T' },
+    { "top_k", required_argument, nullptr, 'k' },
+    { "cache_dir", required_argument, nullptr, 'c' },
+    { "estimator_calibration", required_argument, nullptr, 'e' },
+    { "incremental", no_argument, nullptr, 'r' },
+    { "search", required_argument, nullptr, 'S' },
+    { "heft", no_argument, nullptr, 'H' },
+    { "comm_splits", no_argument, nullptr, 'C' },
     { "help", no_argument, nullptr, 'h' },
     { 0, 0, 0, 0 }
 };
@@ -48,11 +51,14 @@ void usage( const char *argv0 ) {
        << " [-g,--num_gpus NUM_GPUS] [-w, --num_waves NUM_WAVES]"
        << " [-p,--port_count PORT_COUNT] [-o, --num_ocs NUM_OCS]"
        << " [-i,--input_profile INPUT_PROFILE] [-l,--log_dir LOG_DIR]" << endl
+       << " [-P,--pipelined | -W,--windowed] [-T,--threads NUM_THREADS]"
+       << " [-k,--top_k TOP_K] [-c,--cache_dir CACHE_DIR]"
+       << " [-e,--estimator_calibration CALIBRATION_FILE] [-r,--incremental] [-S,--search ITERATIONS] [-H,--heft] [-C,--comm_splits]"
        << endl;
 }
 
 int main( int argc, char **argv ) {
-  uint16_t num_gpus = 0;
+  DeviceId num_gpus = 0;
   uint16_t num_waves = 0;
   uint16_t num_ocs = 0;
   uint16_t port_count = 0;
@@ -61,6 +67,15 @@ int main( int argc, char **argv ) {
 
   string input_profile;
   string log_dir;
+  SimMode mode = SimMode::SERIAL;
+  size_t num_threads = 1;
+  size_t top_k = 0;
+  string cache_dir;
+  string calibration_file;
+  bool incremental = false;
+  size_t search_iterations = 0;
+  bool heft = false;
+  bool comm_splits = false;
   bool is_auto_strategy = true;
   uint32_t dp_degree;
   uint32_t mp_degree;
@@ -73,7 +88,7 @@ int main( int argc, char **argv ) {
     /* getopt_long stores the option index here. */
     int option_index = 0;
 
-    const int opt = getopt_long( argc, argv, "g:w:o:p:m:d:n:i:l:t:s:z:h", command_line_options, &option_index );
+    const int opt = getopt_long( argc, argv, "g:w:o:p:m:d:n:i:l:t:s:z:PWT:k:c:e:rS:HCh", command_line_options, &option_index );
 
     /* Detect the end of the options. */
     if ( opt == - 1 )
@@ -119,6 +134,26 @@ int main( int argc, char **argv ) {
         break;
       case 'z': step_size_sec = stod( optarg ); 
         break;
+      case 'P':mode = SimMode::PIPELINED;
+        break;
+      case 'W':mode = SimMode::WINDOWED;
+        break;
+      case 'T':num_threads = stoul( optarg );
+        break;
+      case 'k':top_k = stoul( optarg );
+        break;
+      case 'c':cache_dir = optarg;
+        break;
+      case 'e':calibration_file = optarg;
+        break;
+      case 'r':incremental = true;
+        break;
+      case 'S':search_iterations = stoul( optarg );
+        break;
+      case 'H':heft = true;
+        break;
+      case 'C':comm_splits = true;
+        break;
       case 'h':usage( argv[ 0 ] );
         return EXIT_SUCCESS;
         break;
@@ -167,10 +202,12 @@ int main( int argc, char **argv ) {
   cnfg.summary( );
 
   /* create gpus */
+  SimContext ctx;
   auto gpus = new GPU[num_gpus];
-  for ( int i = 0; i < num_gpus; i ++ ) {
+  for ( DeviceId i = 0; i < num_gpus; i ++ ) {
     gpus[ i ].cnfg = &cnfg;
-    gpus[ i ].setup_transport( num_gpus );
+    gpus[ i ].join( ctx ).ok( );
+    gpus[ i ].setup_transport( );
   }
 
   /* traffic matrix estimator required for configuring
@@ -208,8 +245,38 @@ int main( int argc, char **argv ) {
                      d_max,
                      cnfg,
                      log_dir );
+  strategy.set_num_threads( num_threads ).ok( );
+  strategy.set_incremental( incremental ).ok( );
+  strategy.set_search_iterations( search_iterations ).ok( );
+  strategy.set_heft( heft ).ok( );
+  strategy.set_comm_splits( comm_splits ).ok( );
+  if ( ! cache_dir.empty( )) {
+    if ( system( ( "mkdir -p " + cache_dir ).c_str( )) == - 1 )
+      cerr << "Error :  " << strerror(errno) << endl;
+    strategy.set_cache_dir( cache_dir ).ok( );
+  }
+  if ( ! calibration_file.empty( )) {
+    EstimatorCalibration calibration;
+    if ( EstimatorCalibration::load( calibration_file, cnfg.inter_type, calibration ) == ExitStatus::SUCCESS )
+      strategy.set_calibration( calibration ).ok( );
+    else
+      cerr << "No " << EstimatorCalibration::topology_name( cnfg.inter_type ) << " calibration in " << calibration_file << endl;
+  }
+
+  /* with a top_k, the best estimated strategies are simulated, each on its
+   * own copy of the cluster logging to LOG_DIR/top_k/ */
+  const string top_k_log_dir = log_dir + "top_k/";
+  const InterconnectFactory factory = ocs_factory( bw_per_port_bytes, num_ocs, port_count, single_shot );
+  auto simulate = [ & ]( const CG &candidate, Step max_steps, Step &num_steps ) {
+    return simulate_copy( candidate, num_gpus, cnfg, factory, min< uint64_t >( max_steps, 1000000 ), mode, top_k_log_dir, num_steps );
+  };
+  if ( top_k > 0 && system( ( "mkdir -p " + top_k_log_dir ).c_str( )) == - 1 )
+    cerr << "Error :  " << strerror(errno) << endl;
+
   CG final_graph;
-  if ( is_auto_strategy )
+  if ( is_auto_strategy && top_k > 0 )
+    strategy.optimize_batchsize( final_graph, top_k, simulate ).ok( );
+  else if ( is_auto_strategy )
     strategy.optimize_batchsize( final_graph ).ok( );
   else {
     Step est_steps;
@@ -228,11 +295,9 @@ int main( int argc, char **argv ) {
 
   /* Setup the inteconnect ILP solver given the compute graph */
   int max_src_dst = 0;
-  for ( int src = 0; src < num_gpus; src++ ){
-    for ( int dst = 0; dst < num_gpus; dst++ ){
-      if ( tm_estimator->tm_est.get_elem( src, dst ) > 0 ){
-        max_src_dst = max( max_src_dst, max( src, dst ) );
-      }
+  for ( const auto &e : tm_estimator->tm_est ){
+    if ( e.value > 0 ){
+      max_src_dst = max( max_src_dst, int( max( e.row, e.col ) ) );
     }
   }
   int eff_num_gpus = max_src_dst + 1;
@@ -241,14 +306,8 @@ int main( int argc, char **argv ) {
   interconnect.set_eff_num_gpus( eff_num_gpus ); /* to speed-up the OCS solver */
   interconnect.setup_optimal_solver( );
 
-  bool done = false;
-  for ( int it = 0; it < 1000000; it ++ ) {
-    session.proceed( done ).ok( );
-    if ( done )
-      break;
-    interconnect.proceed( ).ok( );
-    Device::curr_step ++;
-  }
+  interconnect.set_num_threads( num_threads ).ok( );
+  run_simulation( session, interconnect, 1000000, mode ).ok( );
   delete[] gpus;
   return 0;
 }
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <iomanip>
 #include <cstdint>
+#include <memory>
 #include <assert.h>
 #include <sys/stat.h>
 #include "../utils/matrix.hh"
@@ -9,6 +10,7 @@
 #include "../interconnect/interconnect.hh"
 #include "../compute/gpu.hh"
 #include "../executor/session.hh"
+#include "../interconnect/simulation.hh"
 #include "../executor/graph.hh"
 #include "../placement/placement.hh"
 #include "../placement/strategy.hh"
@@ -16,16 +18,7 @@
 
 using namespace std;
 
-uint16_t GPU::dev_count = 0;
-
 const uint16_t Packet::max_pkt_size = 1504; /* bytes */
-uint64_t Packet::num_pkts = 0;
-
-Step Device::curr_step = 0;
-
-NetworkSignal GPU::recv_sig = { };
-
-std::unordered_map< PacketId, Packet * > Transport::flying_pkts = { };
 
 static struct option command_line_options[] = {
     { "num_gpus", required_argument, nullptr, 'g' },
@@ -39,6 +32,16 @@ static struct option command_line_options[] = {
     { "input_profile", required_argument, nullptr, 'i' },
     { "log_dir", required_argument, nullptr, 'l' },
     { "step_size_sec", required_argument, nullptr, 'z' },
+    { "pipelined", no_argument, nullptr, 'P' },
+    { "windowed", no_argument, nullptr, 'W' },
+    { "threads", required_argument, nullptr, 'T' },
+    { "top_k", required_argument, nullptr, 'k' },
+    { "cache_dir", required_argument, nullptr, 'c' },
+    { "estimator_calibration", required_argument, nullptr, 'e' },
+    { "incremental", no_argument, nullptr, 'r' },
+    { "search", required_argument, nullptr, 'S' },
+    { "heft", no_argument, nullptr, 'H' },
+    { "comm_splits", no_argument, nullptr, 'C' },
     { "help", no_argument, nullptr, 'h' },
     { 0, 0, 0, 0 }
 };
@@ -49,18 +52,30 @@ void usage( const char *argv0 ) {
        << " [-d, --max_dist MAX_DIST] [-s, --single_shot SINGLE_SHOT]"
        << " [-b, --bw_decision_type BW_Decision_Type] [-m, --dec_interval_micro BW_DECISION_INTERVAL]"
        << " [-i,--input_profile INPUT_PROFILE] [-l,--log_dir LOG_DIR]" << endl
+       << " [-P,--pipelined | -W,--windowed] [-T,--threads NUM_THREADS]"
+       << " [-k,--top_k TOP_K] [-c,--cache_dir CACHE_DIR]"
+       << " [-e,--estimator_calibration CALIBRATION_FILE] [-r,--incremental] [-S,--search ITERATIONS] [-H,--heft] [-C,--comm_splits]"
        << endl;
 }
 
 int main( int argc, char **argv ) {
-  uint16_t num_gpus = 0;
+  DeviceId num_gpus = 0;
   uint16_t num_waves = 0;
-  uint16_t max_dist = 0;
+  DeviceId max_dist = 0;
   double bw_dec_micro = 0;
   bool single_shot = false;
   BWDecisionType bw_decision_type = BWDecisionType::ILP;
   string input_profile;
   string log_dir;
+  SimMode mode = SimMode::SERIAL;
+  size_t num_threads = 1;
+  size_t top_k = 0;
+  string cache_dir;
+  string calibration_file;
+  bool incremental = false;
+  size_t search_iterations = 0;
+  bool heft = false;
+  bool comm_splits = false;
   bool is_auto_strategy = true;
   uint32_t dp_degree;
   uint32_t mp_degree;
@@ -72,7 +87,7 @@ int main( int argc, char **argv ) {
     /* getopt_long stores the option index here. */
     int option_index = 0;
 
-    const int opt = getopt_long( argc, argv, "g:w:d:s:t:b:m:n:a:i:l:z:h", command_line_options, &option_index );
+    const int opt = getopt_long( argc, argv, "g:w:d:s:t:b:m:n:a:i:l:z:PWT:k:c:e:rS:HCh", command_line_options, &option_index );
 
     /* Detect the end of the options. */
     if ( opt == - 1 )
@@ -121,6 +136,27 @@ int main( int argc, char **argv ) {
       case 'l':log_dir = optarg;
         break;
       case 'z': step_size_sec = stod( optarg );
+        break;
+      case 'P':mode = SimMode::PIPELINED;
+        break;
+      case 'W':mode = SimMode::WINDOWED;
+        break;
+      case 'T':num_threads = stoul( optarg );
+        break;
+      case 'k':top_k = stoul( optarg );
+        break;
+      case 'c':cache_dir = optarg;
+        break;
+      case 'e':calibration_file = optarg;
+        break;
+      case 'r':incremental = true;
+        break;
+      case 'S':search_iterations = stoul( optarg );
+        break;
+      case 'H':heft = true;
+        break;
+      case 'C':comm_splits = true;
+        break;
       case 'h':usage( argv[ 0 ] );
         return EXIT_SUCCESS;
         break;
@@ -171,10 +207,12 @@ int main( int argc, char **argv ) {
   cnfg.summary( );
 
   /* create gpus */
+  SimContext ctx;
   auto gpus = new GPU[num_gpus];
-  for ( int i = 0; i < num_gpus; i ++ ) {
+  for ( DeviceId i = 0; i < num_gpus; i ++ ) {
     gpus[ i ].cnfg = &cnfg;
-    gpus[ i ].setup_transport( num_gpus );
+    gpus[ i ].join( ctx ).ok( );
+    gpus[ i ].setup_transport( );
   }
 
 
@@ -224,8 +262,38 @@ int main( int argc, char **argv ) {
                      max_dist,
                      cnfg,
                      log_dir );
+  strategy.set_num_threads( num_threads ).ok( );
+  strategy.set_incremental( incremental ).ok( );
+  strategy.set_search_iterations( search_iterations ).ok( );
+  strategy.set_heft( heft ).ok( );
+  strategy.set_comm_splits( comm_splits ).ok( );
+  if ( ! cache_dir.empty( )) {
+    if ( system( ( "mkdir -p " + cache_dir ).c_str( )) == - 1 )
+      cerr << "Error :  " << strerror(errno) << endl;
+    strategy.set_cache_dir( cache_dir ).ok( );
+  }
+  if ( ! calibration_file.empty( )) {
+    EstimatorCalibration calibration;
+    if ( EstimatorCalibration::load( calibration_file, cnfg.inter_type, calibration ) == ExitStatus::SUCCESS )
+      strategy.set_calibration( calibration ).ok( );
+    else
+      cerr << "No " << EstimatorCalibration::topology_name( cnfg.inter_type ) << " calibration in " << calibration_file << endl;
+  }
+
+  /* with a top_k, the best estimated strategies are simulated, each on its
+   * own copy of the cluster logging to LOG_DIR/top_k/ */
+  const string top_k_log_dir = log_dir + "top_k/";
+  const InterconnectFactory factory = ring_factory( bw_per_port_bytes, num_waves, bw_decision_type, max_dist, single_shot );
+  auto simulate = [ & ]( const CG &candidate, Step max_steps, Step &num_steps ) {
+    return simulate_copy( candidate, num_gpus, cnfg, factory, min< uint64_t >( max_steps, 1000000 ), mode, top_k_log_dir, num_steps );
+  };
+  if ( top_k > 0 && system( ( "mkdir -p " + top_k_log_dir ).c_str( )) == - 1 )
+    cerr << "Error :  " << strerror(errno) << endl;
+
   CG final_graph;
-  if ( is_auto_strategy )
+  if ( is_auto_strategy && top_k > 0 )
+    strategy.optimize_batchsize( final_graph, top_k, simulate ).ok( );
+  else if ( is_auto_strategy )
     strategy.optimize_batchsize( final_graph ).ok( );
   else {
     Step est_steps;
@@ -244,11 +312,9 @@ int main( int argc, char **argv ) {
   tm_estimator->log( );
 
   int max_src_dst = 0;
-  for ( int src = 0; src < num_gpus; src++ ){
-    for ( int dst = 0; dst < num_gpus; dst++ ){
-      if ( tm_estimator->tm_est.get_elem( src, dst ) > 0 ){
-        max_src_dst = max( max_src_dst, max( src, dst ) );
-      }
+  for ( const auto &e : tm_estimator->tm_est ){
+    if ( e.value > 0 ){
+      max_src_dst = max( max_src_dst, int( max( e.row, e.col ) ) );
     }
   }
   int eff_num_gpus = max_src_dst + 1;
@@ -262,14 +328,8 @@ int main( int argc, char **argv ) {
   }
 //  cout << tm_estimator->tm_est;
 
-  bool done = false;
-  for ( int it = 0; it < 1000000; it ++ ) {
-    session.proceed( done ).ok( );
-    if ( done )
-      break;
-    interconnect.proceed( ).ok( );
-    Device::curr_step ++;
-  }
+  interconnect.set_num_threads( num_threads ).ok( );
+  run_simulation( session, interconnect, 1000000, mode ).ok( );
   delete[] gpus;
   return 0;
 }
@@ -0,0 +1,534 @@
+#include <getopt.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <assert.h>
+#include <sys/stat.h>
+#include "sim_config.hh"
+#include "interconnect.hh"
+#include "gpu.hh"
+#include "session.hh"
+#include "simulation.hh"
+#include "graph.hh"
+#include "placement.hh"
+#include "strategy.hh"
+#include "utils.hh"
+
+#define MAX_NUM_ITERATIONS 1000000
+
+using namespace std;
+
+const uint16_t Packet::max_pkt_size = 1504; /* bytes */
+
+static struct option command_line_options[] = {
+    { "spec", required_argument, nullptr, 's' },
+    { "log_dir", required_argument, nullptr, 'l' },
+    { "jobs", required_argument, nullptr, 'j' },
+    { "output", required_argument, nullptr, 'o' },
+    { "cache_dir", required_argument, nullptr, 'c' },
+    { "estimator_calibration", required_argument, nullptr, 'e' },
+    { "fit_calibration", required_argument, nullptr, 'f' },
+    { "incremental", no_argument, nullptr, 'r' },
+    { "search", required_argument, nullptr, 'S' },
+    { "heft", no_argument, nullptr, 'H' },
+    { "comm_splits", no_argument, nullptr, 'C' },
+    { "help", no_argument, nullptr, 'h' },
+    { 0, 0, 0, 0 }
+};
+
+void usage( const char *argv0 ) {
+  cerr << "Usage: " << argv0
+       << " [-s,--spec SWEEP_SPEC] [-l,--log_dir LOG_DIR]"
+       << " [-j,--jobs NUM_JOBS] [-o,--output RESULTS_FILE] [-c,--cache_dir CACHE_DIR]" << endl
+       << " [-e,--estimator_calibration CALIBRATION_FILE] [-f,--fit_calibration CALIBRATION_FILE]" << endl
+       << "  ( --fit_calibration fits the estimated iteration time, not the per-op times )" << endl
+       << " [-r,--incremental] [-S,--search ITERATIONS] [-H,--heft] [-C,--comm_splits]" << endl
+       << "Each line of SWEEP_SPEC is one point, given as key=value pairs:" << endl
+       << "  topology=elect|fullmesh|ocs|ring profile=INPUT_PROFILE num_gpus=NUM_GPUS" << endl
+       << "  [strategy=auto|DP:MP:BS] [name=NAME] [step_size_sec=SEC] [num_profiles=N]" << endl
+       << "  elect:    [bw_Gb=GBPS] [latency_us=US]" << endl
+       << "  fullmesh: [num_waves=N]" << endl
+       << "  ocs:      [num_waves=N] [num_ocs=N] [port_count=N] [dec_interval_micro=US] [single_shot=0|1]" << endl
+       << "  ring:     [num_waves=N] [max_dist=N] [bw_decision=ILP|MINCOSTFLOW] [dec_interval_micro=US] [single_shot=0|1]" << endl
+       << "Empty lines and lines starting with # are skipped." << endl;
+}
+
+/* one run of the sweep; the keys not given in the spec keep the defaults
+ * of the corresponding sipml-* binary */
+struct SweepPoint {
+  string name { };
+  string topology { };
+  string profile { };
+  DeviceId num_gpus = 0;
+  string strategy = "auto";
+  double step_size_sec = 0; /* 0: the binary's default */
+  int num_profiles = 10;
+  double bw_Gb = 0;
+  uint32_t latency_us = 1;
+  uint16_t num_waves = 0;
+  double dec_interval_micro = 0;
+  uint16_t num_ocs = 0;
+  uint16_t port_count = 0;
+  DeviceId max_dist = 0;
+  BWDecisionType bw_decision = BWDecisionType::ILP;
+  bool single_shot = false;
+};
+
+/* options of the whole sweep, shared by every point */
+struct SweepOptions {
+  string cache_dir { };
+  string calibration_file { }; /* applied to the strategy search */
+  bool fit_calibration = false;
+  bool incremental = false; /* re-cost placements across batch sizes */
+  size_t search_iterations = 0; /* of the placement search, if any */
+  bool heft = false; /* place with HEFT instead of MP */
+  bool comm_splits = false; /* split ops by what their transfers cost */
+};
+
+struct SweepResult {
+  bool done = false;
+  Step pass_steps = 0;
+  /* with --fit_calibration: the estimate of the simulated graph, and its
+   * estimate under each of calibration_grid( ) */
+  Step est_steps = 0;
+  vector< Step > grid_est_steps { };
+  double wall_sec = 0;
+  string error { };
+};
+
+/* a profile parsed once and shared by every point using it; points only
+ * read it, each one placing its own clone of the graph */
+struct Workload {
+  CG graph { };
+  map< uint32_t, uint32_t > bs2niter_map { };
+};
+
+using WorkloadKey = tuple< string, double, int >;
+
+ExitStatus parse_point( const string &line, size_t index, SweepPoint &point ) {
+  istringstream tokens( line );
+  string token;
+  while ( tokens >> token ) {
+    size_t pos = token.find( '=' );
+    if ( pos == string::npos )
+      throw runtime_error( "expected key=value, got " + token );
+    const string key = token.substr( 0, pos );
+    const string value = token.substr( pos + 1 );
+    if ( key == "name" ) point.name = value;
+    else if ( key == "topology" ) point.topology = value;
+    else if ( key == "profile" ) point.profile = value;
+    else if ( key == "num_gpus" ) point.num_gpus = stoul( value );
+    else if ( key == "strategy" ) point.strategy = value;
+    else if ( key == "step_size_sec" ) point.step_size_sec = stod( value );
+    else if ( key == "num_profiles" ) point.num_profiles = stoi( value );
+    else if ( key == "bw_Gb" ) point.bw_Gb = stod( value );
+    else if ( key == "latency_us" ) point.latency_us = stoul( value );
+    else if ( key == "num_waves" ) point.num_waves = stoul( value );
+    else if ( key == "dec_interval_micro" ) point.dec_interval_micro = stod( value );
+    else if ( key == "num_ocs" ) point.num_ocs = stoul( value );
+    else if ( key == "port_count" ) point.port_count = stoul( value );
+    else if ( key == "max_dist" ) point.max_dist = stoul( value );
+    else if ( key == "single_shot" ) point.single_shot = stoi( value ) != 0;
+    else if ( key == "bw_decision" ) {
+      if ( value == "ILP" )
+        point.bw_decision = BWDecisionType::ILP;
+      else if ( value == "MINCOSTFLOW" )
+        point.bw_decision = BWDecisionType::MINCOSTFLOW;
+      else
+        throw runtime_error( "unknown bw_decision " + value );
+    } else
+      throw runtime_error( "unknown key " + key );
+  }
+  if ( point.topology != "elect" && point.topology != "fullmesh"
+      && point.topology != "ocs" && point.topology != "ring" )
+    throw runtime_error( "unknown topology " + point.topology );
+  if ( point.profile.empty( ) || point.num_gpus == 0 )
+    throw runtime_error( "profile and num_gpus are required" );
+  if ( point.step_size_sec == 0 )
+    point.step_size_sec = point.topology == "fullmesh" ? 1e-6 : 1e-4;
+  if ( point.name.empty( ))
+    point.name = point.topology + "_g" + to_string( point.num_gpus ) + "_" + to_string( index );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus read_spec( const string &filename, vector< SweepPoint > &points ) {
+  ifstream file( filename );
+  if ( ! file.is_open( ))
+    throw runtime_error( "couldn't read the sweep spec " + filename );
+  string line;
+  size_t line_num = 0;
+  while ( getline( file, line )) {
+    line_num ++;
+    size_t first = line.find_first_not_of( " \t" );
+    if ( first == string::npos || line[ first ] == '#' )
+      continue;
+    SweepPoint point;
+    try {
+      parse_point( line, points.size( ), point ).ok( );
+    } catch ( const exception &e ) {
+      throw runtime_error( filename + ":" + to_string( line_num ) + ": " + e.what( ));
+    }
+    points.push_back( point );
+  }
+  return ExitStatus::SUCCESS;
+}
+
+InterType inter_type_of( const string &topology ) {
+  if ( topology == "elect" )
+    return InterType::ELECTSW;
+  if ( topology == "fullmesh" )
+    return InterType::FULLMESH;
+  return topology == "ocs" ? InterType::OCS : InterType::RING;
+}
+
+/* how the point's interconnect is set up; mirrors the sipml-* binaries */
+InterconnectFactory make_factory( const SweepPoint &point ) {
+  if ( point.topology == "elect" )
+    return electrical_switch_factory( point.bw_Gb * 1e9 / 8 );
+  double bw_per_port_bytes = double( point.num_waves * BW_PER_WAVE_BYTES );
+  if ( point.topology == "fullmesh" )
+    return fullmesh_factory( bw_per_port_bytes );
+  if ( point.topology == "ocs" )
+    return ocs_factory( bw_per_port_bytes, point.num_ocs, point.port_count, point.single_shot );
+  return ring_factory( bw_per_port_bytes, point.num_waves, point.bw_decision, point.max_dist, point.single_shot );
+}
+
+/* the corrections --fit_calibration chooses from: a bandwidth efficiency
+ * of 0.25 to 2 in steps of 0.05, times a transfer overhead of 0 to 1ms */
+vector< EstimatorCalibration > calibration_grid( ) {
+  const double overheads_us[] = { 0, 0.1, 0.2, 0.5, 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+  vector< EstimatorCalibration > grid;
+  for ( int eff = 5; eff <= 40; eff ++ ) {
+    for ( double overhead_us : overheads_us ) {
+      EstimatorCalibration calibration;
+      calibration.bw_efficiency = eff * 0.05;
+      calibration.net_overhead_sec = overhead_us * 1e-6;
+      grid.push_back( calibration );
+    }
+  }
+  return grid;
+}
+
+/* where the estimate and the simulation put each op of the graph */
+ExitStatus write_estimate_error( const string &filename, const CG &graph, const map< Op *, pair< Step, Step > > &est_times ) {
+  ofstream out( filename );
+  out << "op\ttype\tsrc\tdst\test_start\test_end\tsim_start\tsim_end\tstart_error\tend_error" << endl;
+  for ( auto e : graph.adj ) {
+    Op *op = e.first;
+    const pair< Step, Step > &est = est_times.at( op );
+    out << op->name << "\t" << int( op->type ) << "\t";
+    if ( op->type == OpType::NETWORK ) {
+      auto net_op = static_cast<NetOp *>( op );
+      out << net_op->src_device->dev_id << "\t" << net_op->dst_device->dev_id;
+    } else if ( op->device != nullptr ) {
+      out << op->device->dev_id << "\t" << op->device->dev_id;
+    } else {
+      out << "-\t-";
+    }
+    out << "\t" << est.first << "\t" << est.second << "\t" << op->start << "\t" << op->end << "\t"
+        << int64_t( est.first ) - int64_t( op->start ) << "\t" << int64_t( est.second ) - int64_t( op->end ) << endl;
+  }
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus run_point( const SweepPoint &point,
+                      const Workload &workload,
+                      const string &log_dir,
+                      const SweepOptions &options,
+                      SweepResult &result ) {
+  const double step_size_sec = point.step_size_sec;
+  const bool is_elect = point.topology == "elect";
+  const bool is_fullmesh = point.topology == "fullmesh";
+  const bool is_ocs = point.topology == "ocs";
+  const bool is_ring = point.topology == "ring";
+  /* the electrical and full-mesh interconnects are configured once */
+  const bool single_shot = point.single_shot || is_fullmesh;
+
+  Step interconnect_reconf_delay = 0;
+  if ( is_ocs )
+    interconnect_reconf_delay = OCS_RECONF_DELAY_SEC / step_size_sec;
+  else if ( is_ring )
+    interconnect_reconf_delay = MRR_RECONF_DELAY_SEC / step_size_sec;
+  Step dec_interval;
+  if ( is_elect || is_fullmesh )
+    dec_interval = numeric_limits< Step >::max( );
+  else if ( single_shot )
+    dec_interval = numeric_limits< Step >::max( ) - interconnect_reconf_delay;
+  else
+    dec_interval = point.dec_interval_micro * 1e-6 / step_size_sec;
+  InterType inter_type = inter_type_of( point.topology );
+  const Step interconnect_latency = is_elect ? Step( double( point.latency_us ) * 1e-6 / step_size_sec )
+                                             : Step( INTERCONNECT_LATENCY_SEC / step_size_sec );
+  SimConfig cnfg( is_elect ? 0 : point.num_waves,
+                  inter_type,
+                  BW_PER_WAVE_BYTES * step_size_sec,
+                  dec_interval,
+                  interconnect_reconf_delay,
+                  GPU_LAUNCH_LATENCY_SEC / step_size_sec,
+                  GPU_MIN_COMP_TIME_SEC / step_size_sec,
+                  interconnect_latency,
+                  PCIE_LATENCY_SEC / step_size_sec,
+                  step_size_sec );
+
+  /* the cluster the strategy is placed on and simulated */
+  const InterconnectFactory factory = make_factory( point );
+  SimCluster cluster( point.num_gpus, cnfg );
+  factory.build( cluster, log_dir ).ok( );
+
+  CG graph { };
+  workload.graph.clone( graph ).ok( );
+  DeviceId d_max = is_ocs ? point.num_ocs : is_ring ? point.max_dist : point.num_gpus;
+  Step batch_quant_step = 1e-6 / cnfg.step_size_sec;
+  Strategy strategy( graph,
+                     cluster.interconnect.get( ),
+                     workload.bs2niter_map,
+                     batch_quant_step,
+                     cluster.gpus.get( ),
+                     d_max,
+                     cnfg,
+                     log_dir );
+  if ( ! options.cache_dir.empty( ))
+    strategy.set_cache_dir( options.cache_dir ).ok( );
+  strategy.set_incremental( options.incremental ).ok( );
+  strategy.set_search_iterations( options.search_iterations ).ok( );
+  strategy.set_heft( options.heft ).ok( );
+  strategy.set_comm_splits( options.comm_splits ).ok( );
+  EstimatorCalibration calibration;
+  if ( ! options.calibration_file.empty( )
+      && EstimatorCalibration::load( options.calibration_file, inter_type, calibration ) == ExitStatus::SUCCESS )
+    strategy.set_calibration( calibration ).ok( );
+  CG final_graph;
+  if ( point.strategy == "auto" )
+    strategy.optimize_batchsize( final_graph ).ok( );
+  else {
+    string strat = point.strategy;
+    size_t pos = strat.find( ':' );
+    uint32_t dp_degree = stoul( strat.substr( 0, pos ));
+    strat.erase( 0, pos + 1 );
+    pos = strat.find( ':' );
+    uint32_t mp_degree = stoul( strat.substr( 0, pos ));
+    strat.erase( 0, pos + 1 );
+    uint32_t global_bs = stoul( strat );
+    Step est_steps;
+    strategy.get_hybrid_placement( dp_degree, mp_degree, global_bs, est_steps, final_graph ).ok( );
+  }
+
+  /* the estimate is taken before the session starts the graph, which
+   * resets the ops' start and end times */
+  map< Op *, pair< Step, Step > > est_times;
+  if ( options.fit_calibration ) {
+    BWEstimate bw_est;
+    cluster.interconnect->offline_bw_est( bw_est ).ok( );
+    MP estimator( cluster.interconnect.get( ), cluster.gpus.get( ), point.num_gpus, CG( ), { }, point.num_gpus, d_max );
+    for ( const auto &grid_calibration : calibration_grid( )) {
+      Step est_steps;
+      estimator.set_calibration( grid_calibration ).ok( );
+      estimator.estimate_iter_time( final_graph, bw_est, est_steps ).ok( );
+      result.grid_est_steps.push_back( est_steps );
+    }
+    estimator.set_calibration( calibration ).ok( );
+    estimator.estimate_iter_time( final_graph, bw_est, result.est_steps ).ok( );
+    for ( auto e : final_graph.adj )
+      est_times[ e.first ] = make_pair( e.first->start, e.first->end );
+  }
+
+  result.done = simulate_graph( cluster, factory, final_graph, MAX_NUM_ITERATIONS, SimMode::SERIAL, log_dir, true /* log_tm */, result.pass_steps ) == ExitStatus::SUCCESS;
+  if ( options.fit_calibration )
+    write_estimate_error( log_dir + "estimate_error.tsv", final_graph, est_times ).ok( );
+  return ExitStatus::SUCCESS;
+}
+
+ExitStatus write_results( ostream &out, const vector< SweepPoint > &points, const vector< SweepResult > &results ) {
+  out << "name\ttopology\tnum_gpus\tstrategy\tpass_steps\tpass_sec\twall_sec\tstatus" << endl;
+  for ( size_t i = 0; i < points.size( ); i ++ ) {
+    const SweepPoint &point = points[ i ];
+    const SweepResult &result = results[ i ];
+    out << point.name << "\t" << point.topology << "\t" << point.num_gpus << "\t" << point.strategy << "\t";
+    if ( result.done )
+      out << result.pass_steps << "\t" << result.pass_steps * point.step_size_sec;
+    else
+      out << "-\t-";
+    out << "\t" << fixed << setprecision( 2 ) << result.wall_sec << defaultfloat << setprecision( 6 ) << "\t";
+    if ( ! result.error.empty( ))
+      out << "error: " << result.error;
+    else
+      out << ( result.done ? "ok" : "unfinished" );
+    out << endl;
+  }
+  return ExitStatus::SUCCESS;
+}
+
+/* per topology, the calibration from calibration_grid( ) with the least
+ * squared relative error of the estimated iteration times over the
+ * finished points. The fit is to whole iterations only: the per-op errors
+ * in each point's estimate_error.tsv are written for inspection, not
+ * fitted to */
+ExitStatus fit_calibration( ostream &out, const vector< SweepPoint > &points, const vector< SweepResult > &results ) {
+  const vector< EstimatorCalibration > grid = calibration_grid( );
+  for ( const string topology : { "elect", "fullmesh", "ocs", "ring" } ) {
+    vector< double > grid_error( grid.size( ), 0 );
+    double est_error = 0;
+    size_t num_points = 0;
+    for ( size_t i = 0; i < points.size( ); i ++ ) {
+      const SweepResult &result = results[ i ];
+      if ( points[ i ].topology != topology || ! result.done || ! result.error.empty( ) || result.pass_steps == 0 )
+        continue;
+      const double sim = result.pass_steps;
+      for ( size_t g = 0; g < grid.size( ); g ++ )
+        grid_error[ g ] += pow( ( double( result.grid_est_steps[ g ] ) - sim ) / sim, 2 );
+      est_error += pow( ( double( result.est_steps ) - sim ) / sim, 2 );
+      num_points ++;
+      out << "# " << points[ i ].name << ": est_steps=" << result.est_steps << " sim_steps=" << result.pass_steps << endl;
+    }
+    if ( num_points == 0 )
+      continue;
+    const size_t best = min_element( grid_error.begin( ), grid_error.end( )) - grid_error.begin( );
+    out << "# " << num_points << " points, fitted to the iteration time only; rms relative error "
+        << sqrt( est_error / num_points ) << " -> " << sqrt( grid_error[ best ] / num_points ) << endl;
+    out << grid[ best ].to_string( topology ) << endl;
+  }
+  return ExitStatus::SUCCESS;
+}
+
+int main( int argc, char **argv ) {
+  string spec_file;
+  string log_dir;
+  string output_file;
+  SweepOptions options;
+  string fit_file;
+  size_t num_jobs = thread::hardware_concurrency( );
+  /* parse the input options */
+  while ( true ) {
+    /* getopt_long stores the option index here. */
+    int option_index = 0;
+
+    const int opt = getopt_long( argc, argv, "s:l:j:o:c:e:f:rS:HCh", command_line_options, &option_index );
+
+    /* Detect the end of the options. */
+    if ( opt == - 1 )
+      break;
+    switch ( opt ) {
+      case 's':spec_file = optarg;
+        break;
+      case 'l':log_dir = optarg;
+        break;
+      case 'j':num_jobs = stoul( optarg );
+        break;
+      case 'o':output_file = optarg;
+        break;
+      case 'c':options.cache_dir = optarg;
+        break;
+      case 'e':options.calibration_file = optarg;
+        break;
+      case 'f':fit_file = optarg;
+        options.fit_calibration = true;
+        break;
+      case 'r':options.incremental = true;
+        break;
+      case 'S':options.search_iterations = stoul( optarg );
+        break;
+      case 'H':options.heft = true;
+        break;
+      case 'C':options.comm_splits = true;
+        break;
+      case 'h':usage( argv[ 0 ] );
+        return EXIT_SUCCESS;
+        break;
+      default:usage( argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+  }
+  if ( spec_file.empty( )) {
+    usage( argv[ 0 ] );
+    return EXIT_FAILURE;
+  }
+  if ( ! log_dir.empty( ) && log_dir.back( ) != '/' )
+    log_dir += "/";
+  if ( ! options.cache_dir.empty( ) && system( ( "mkdir -p " + options.cache_dir ).c_str( )) == - 1 )
+    cerr << "Error :  " << strerror(errno) << endl;
+
+  vector< SweepPoint > points;
+  read_spec( spec_file, points ).ok( );
+  if ( num_jobs == 0 )
+    num_jobs = 1;
+  num_jobs = min( num_jobs, points.size( ));
+
+  /* like the sipml-* binaries, say which topologies run uncalibrated */
+  if ( ! options.calibration_file.empty( )) {
+    set< InterType > topologies;
+    for ( const auto &point : points )
+      topologies.insert( inter_type_of( point.topology ));
+    for ( InterType inter_type : topologies ) {
+      EstimatorCalibration calibration;
+      if ( EstimatorCalibration::load( options.calibration_file, inter_type, calibration ) != ExitStatus::SUCCESS )
+        cerr << "No " << EstimatorCalibration::topology_name( inter_type ) << " calibration in " << options.calibration_file << endl;
+    }
+  }
+
+  /* create the log directories up front, one per point */
+  for ( const auto &point : points ) {
+    string mkdir_cmnd = "mkdir -p " + log_dir + point.name;
+    if ( system( mkdir_cmnd.c_str( )) == - 1 )
+      cerr << "Error :  " << strerror(errno) << endl;
+  }
+
+  /* parse every distinct profile once, before any point starts */
+  map< WorkloadKey, unique_ptr< Workload > > workloads;
+  for ( const auto &point : points ) {
+    WorkloadKey key( point.profile, point.step_size_sec, point.num_profiles );
+    if ( workloads.count( key ))
+      continue;
+    unique_ptr< Workload > workload( new Workload( ));
+    workload->graph.from_graph_profile( point.profile, point.step_size_sec, point.num_profiles );
+    workload->graph.set_global_batchsize( 64 );
+    batch2niter_map_fromfile( point.profile, workload->bs2niter_map );
+    workloads.emplace( key, std::move( workload ));
+  }
+  cout << "sweep: " << points.size( ) << " points, " << workloads.size( ) << " profiles, "
+       << num_jobs << " jobs" << endl;
+
+  /* each worker takes the next point that hasn't been started */
+  vector< SweepResult > results( points.size( ));
+  atomic< size_t > next_point( 0 );
+  auto worker = [ & ]( ) {
+    for ( size_t i = next_point ++; i < points.size( ); i = next_point ++ ) {
+      const SweepPoint &point = points[ i ];
+      const Workload &workload = *workloads.at( WorkloadKey( point.profile, point.step_size_sec, point.num_profiles ));
+      auto start = chrono::steady_clock::now( );
+      try {
+        run_point( point, workload, log_dir + point.name + "/", options, results[ i ] ).ok( );
+      } catch ( const exception &e ) {
+        results[ i ].error = e.what( );
+      }
+      results[ i ].wall_sec = chrono::duration< double >( chrono::steady_clock::now( ) - start ).count( );
+    }
+  };
+  vector< thread > workers;
+  for ( size_t t = 1; t < num_jobs; t ++ )
+    workers.emplace_back( worker );
+  worker( );
+  for ( auto &t : workers )
+    t.join( );
+
+  for ( auto &workload : workloads )
+    workload.second->graph.release_ops( ).ok( );
+
+  if ( output_file.empty( ))
+    output_file = log_dir + "sweep.tsv";
+  ofstream out( output_file );
+  write_results( out, points, results ).ok( );
+  write_results( cout, points, results ).ok( );
+  if ( options.fit_calibration ) {
+    ofstream fit_out( fit_file );
+    fit_calibration( fit_out, points, results ).ok( );
+    fit_calibration( cout, points, results ).ok( );
+  }
+  return 0;
+}
@@ -4,8 +4,14 @@
 #include <stdexcept>
 #include <cstring>
 #include <limits>
+#include <new>
 #include <iostream>
 
+/* rows are padded to a multiple of this many bytes (a cache line, and
+ * a whole number of AVX2/AVX-512 vectors) so the elementwise kernels
+ * below can run over aligned, contiguous memory */
+#define MATRIX_ALIGN_BYTES 64
+
 template< class T >
 class Matrix2D;
 
@@ -15,17 +21,20 @@ std::ostream &operator<<( std::ostream &, const Matrix2D< T > & );
 template< class dtype >
 class Matrix2D {
  public:
-  Matrix2D( size_t n_cols, size_t n_rows ) : n_cols( n_cols ), n_rows( n_rows ), mat( nullptr ) {
-    mat = new dtype *[n_rows];
-    for ( size_t row = 0; row < n_rows; row ++ )
-      mat[ row ] = new dtype[n_cols];
+  Matrix2D( size_t n_cols, size_t n_rows ) : n_cols( n_cols ),
+                                             n_rows( n_rows ),
+                                             stride( padded_stride( n_cols )),
+                                             mat( nullptr ) {
+    void *buff = nullptr;
+    size_t num_bytes = n_rows * stride * sizeof( dtype );
+    if ( posix_memalign( &buff, MATRIX_ALIGN_BYTES, num_bytes > 0 ? num_bytes : MATRIX_ALIGN_BYTES ) != 0 )
+      throw std::bad_alloc( );
+    mat = static_cast< dtype * >( buff );
     fill_zeros( );
   }
 
   virtual ~Matrix2D( ) {
-    for ( size_t row = 0; row < n_rows; row ++ )
-      delete[] mat[ row ];
-    delete[] mat;
+    free( mat );
   }
 
   Matrix2D( const Matrix2D & ) = delete;
@@ -34,7 +43,21 @@ class Matrix2D {
  private:
   size_t n_cols;
   size_t n_rows;
-  dtype **mat;
+  size_t stride; /* number of elements between the starts of two consecutive rows */
+  dtype *mat;    /* a single row-major buffer of n_rows x stride elements; the padding is kept zero */
+
+  static size_t padded_stride( size_t n_cols ) {
+    const size_t elems_per_line = ( MATRIX_ALIGN_BYTES % sizeof( dtype ) == 0 ?
+                                    MATRIX_ALIGN_BYTES / sizeof( dtype ) : 1 );
+    return ( n_cols + elems_per_line - 1 ) / elems_per_line * elems_per_line;
+  }
+
+  dtype *row_begin( size_t row ) const {
+    return static_cast< dtype * >( __builtin_assume_aligned( mat + row * stride, MATRIX_ALIGN_BYTES ));
+  }
+
+  static dtype row_max( const dtype *__restrict row, size_t begin, size_t end, dtype max_data );
+
  public:
   void fill_zeros( );
 
@@ -65,40 +88,59 @@ class Matrix2D {
 
 template< class dtype >
 void Matrix2D< dtype >::fill_zeros( ) {
-  for ( size_t row = 0; row < n_rows; row ++ ) {
-    for ( size_t col = 0; col < n_cols; col ++ )
-      mat[ row ][ col ] = 0;
-  }
+  /* also clears the row padding */
+  memset( mat, 0, n_rows * stride * sizeof( dtype ));
 }
 
 template< class dtype >
 void Matrix2D< dtype >::add_by( const Matrix2D< dtype > &matrix_2_d ) {
+  if ( matrix_2_d.stride == stride ) {
+    /* the padding is zero on both sides, so the whole buffer is one flat vector */
+    dtype *__restrict dst = row_begin( 0 );
+    const dtype *__restrict src = matrix_2_d.row_begin( 0 );
+    const size_t size = n_rows * stride;
+    for ( size_t i = 0; i < size; i ++ )
+      dst[ i ] += src[ i ];
+    return;
+  }
   for ( size_t row = 0; row < n_rows; row ++ ) {
-    for ( size_t col = 0; col < n_cols; col ++ ) {
-      mat[ row ][ col ] += matrix_2_d.get_elem( row, col );
-    }
+    dtype *__restrict dst = row_begin( row );
+    const dtype *__restrict src = matrix_2_d.row_begin( row );
+    for ( size_t col = 0; col < n_cols; col ++ )
+      dst[ col ] += src[ col ];
   }
 }
 
 template< class dtype >
 void Matrix2D< dtype >::sub_by( const Matrix2D< dtype > &matrix_2_d ) {
+  if ( matrix_2_d.stride == stride ) {
+    dtype *__restrict dst = row_begin( 0 );
+    const dtype *__restrict src = matrix_2_d.row_begin( 0 );
+    const size_t size = n_rows * stride;
+    for ( size_t i = 0; i < size; i ++ )
+      dst[ i ] -= src[ i ];
+    return;
+  }
   for ( size_t row = 0; row < n_rows; row ++ ) {
+    dtype *__restrict dst = row_begin( row );
+    const dtype *__restrict src = matrix_2_d.row_begin( row );
     for ( size_t col = 0; col < n_cols; col ++ )
-      mat[ row ][ col ] -= matrix_2_d.get_elem( row, col );
+      dst[ col ] -= src[ col ];
   }
 }
 
 template< class dtype >
 void Matrix2D< dtype >::mul_by( const dtype &value ) {
-  for ( size_t row = 0; row < n_rows; row ++ ) {
-    for ( size_t col = 0; col < n_cols; col ++ )
-      mat[ row ][ col ] *= value;
-  }
+  const dtype v = value;
+  dtype *__restrict dst = row_begin( 0 );
+  const size_t size = n_rows * stride;
+  for ( size_t i = 0; i < size; i ++ )
+    dst[ i ] *= v;
 }
 
 template< class dtype >
 dtype Matrix2D< dtype >::get_elem( size_t row, size_t col ) const {
-  return mat[ row ][ col ];
+  return mat[ row * stride + col ];
 }
 
 template< class dtype >
@@ -108,51 +150,58 @@ void Matrix2D< dtype >::copy_from( const Matrix2D< dtype > &matrix_2_d ) {
 //  }
   size_t min_n_rows = std::min( matrix_2_d.n_rows, n_rows );
   size_t min_n_cols = std::min( matrix_2_d.n_cols, n_cols );
-  for ( size_t row = 0; row < min_n_rows; row ++ ) {
-    for ( size_t col = 0; col < min_n_cols; col ++ )
-      mat[ row ][ col ] = matrix_2_d.get_elem( row, col ); //todo:use memcpy
+  if ( matrix_2_d.n_cols == n_cols ) {
+    memcpy( mat, matrix_2_d.mat, min_n_rows * stride * sizeof( dtype ));
+    return;
   }
+  for ( size_t row = 0; row < min_n_rows; row ++ )
+    memcpy( row_begin( row ), matrix_2_d.row_begin( row ), min_n_cols * sizeof( dtype ));
+}
+
+template< class dtype >
+dtype Matrix2D< dtype >::row_max( const dtype *__restrict row, size_t begin, size_t end, dtype max_data ) {
+  for ( size_t col = begin; col < end; col ++ )
+    max_data = ( max_data < row[ col ] ? row[ col ] : max_data );
+  return max_data;
 }
 
 template< class dtype >
 void Matrix2D< dtype >::normalize_by_max( ) {
   dtype max_data = std::numeric_limits< dtype >::min( );
   for ( size_t row = 0; row < n_rows; row ++ ) {
-    for ( size_t col = 0; col < n_cols; col ++ )
-        if ( row != col )
-            max_data = ( max_data < mat[ row ][ col ] ? mat[ row ][ col ] : max_data );
+    /* skip the diagonal by splitting the row around it */
+    const dtype *row_data = row_begin( row );
+    max_data = row_max( row_data, 0, std::min( row, n_cols ), max_data );
+    max_data = row_max( row_data, std::min( row + 1, n_cols ), n_cols, max_data );
   }
   if ( max_data != 0 ) {
-    for ( size_t row = 0; row < n_rows; row ++ ) {
-      for ( size_t col = 0; col < n_cols; col ++ ) {
-        mat[ row ][ col ] /= max_data;
-        //mat[ row ][ col ] = double( int( 100. * mat[ row ][ col ] ) ) / 100.;
-        mat[ row ][ col ] = double( mat[ row ][ col ] );
-      }
-    }
+    dtype *__restrict dst = row_begin( 0 );
+    const size_t size = n_rows * stride;
+    for ( size_t i = 0; i < size; i ++ )
+      dst[ i ] /= max_data;
   }
 }
 
 template< class dtype >
 void Matrix2D< dtype >::set_elem( size_t row, size_t col, const dtype value ) {
-  mat[ row ][ col ] = value;
+  mat[ row * stride + col ] = value;
 }
 
 template< class dtype >
 void Matrix2D< dtype >::add_elem_by( size_t row, size_t col, const dtype value ) {
-  mat[ row ][ col ] += value;
+  mat[ row * stride + col ] += value;
 }
 
 template< class dtype >
 void Matrix2D< dtype >::sub_elem_by( size_t row, size_t col, const dtype value ) {
-  mat[ row ][ col ] -= value;
+  mat[ row * stride + col ] -= value;
 }
 
 template< class dtype >
 std::ostream &operator<<( std::ostream &os, const Matrix2D< dtype > &d ) {
   for ( size_t row = 0; row < d.n_rows; row ++ ) {
     for ( size_t col = 0; col < d.n_cols; col ++ )
-      os << d.mat[ row ][ col ] << " ";
+      os << d.get_elem( row, col ) << " ";
     os << std::endl;
   }
   return os;
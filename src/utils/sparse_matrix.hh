@@ -0,0 +1,204 @@
+#ifndef ROSTAM_SRC_UTILS_SPARSE_MATRIX_HH_
+#define ROSTAM_SRC_UTILS_SPARSE_MATRIX_HH_
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+
+template< class T >
+class SparseMatrix2D;
+
+template< class T >
+std::ostream &operator<<( std::ostream &, const SparseMatrix2D< T > & );
+
+/* A COO matrix with a hash index over (row, col) for O(1) element updates.
+ * Only non-zero elements are stored: writing a zero removes the element,
+ * so traffic matrices stay proportional to the number of active pairs
+ * rather than num_gpus x num_gpus. */
+template< class dtype >
+class SparseMatrix2D {
+ public:
+  struct Elem {
+    uint32_t row;
+    uint32_t col;
+    dtype value;
+  };
+  using const_iterator = typename std::vector< Elem >::const_iterator;
+
+ public:
+  SparseMatrix2D( size_t n_cols, size_t n_rows ) : n_cols( n_cols ), n_rows( n_rows ), elems( ), index( ) { }
+
+  virtual ~SparseMatrix2D( ) = default;
+
+  SparseMatrix2D( const SparseMatrix2D & ) = delete;
+  SparseMatrix2D &operator=( const SparseMatrix2D & ) = delete;
+
+ private:
+  size_t n_cols;
+  size_t n_rows;
+  std::vector< Elem > elems;
+  std::unordered_map< uint64_t, size_t > index; /* (row, col) key -> position in elems */
+
+  static uint64_t key( size_t row, size_t col ) {
+    return ( uint64_t( row ) << 32 ) | uint64_t( col );
+  }
+
+  void erase_at( size_t pos );
+
+ public:
+  void fill_zeros( );
+
+  dtype get_elem( size_t row, size_t col ) const;
+
+  void set_elem( size_t row, size_t col, const dtype value );
+
+  void add_by( const SparseMatrix2D< dtype > &matrix_2_d );
+
+  void sub_by( const SparseMatrix2D< dtype > &matrix_2_d );
+
+  void mul_by( const dtype &value );
+
+  void add_elem_by( size_t row, size_t col, const dtype value );
+
+  void sub_elem_by( size_t row, size_t col, const dtype value );
+
+  void copy_from( const SparseMatrix2D< dtype > &matrix_2_d );
+
+  void normalize_by_max( );
+
+  size_t nnz( ) const { return elems.size( ); }
+
+  size_t get_n_rows( ) const { return n_rows; }
+
+  size_t get_n_cols( ) const { return n_cols; }
+
+  /* iterate over the non-zero elements; the order is unspecified and
+   * iterators are invalidated by any update */
+  const_iterator begin( ) const { return elems.begin( ); }
+
+  const_iterator end( ) const { return elems.end( ); }
+
+  friend std::ostream &operator
+  <<< dtype >(
+  std::ostream &os,
+  const SparseMatrix2D< dtype > &d
+  );
+};
+
+template< class dtype >
+void SparseMatrix2D< dtype >::erase_at( size_t pos ) {
+  index.erase( key( elems[ pos ].row, elems[ pos ].col ));
+  if ( pos != elems.size( ) - 1 ) {
+    elems[ pos ] = elems.back( );
+    index[ key( elems[ pos ].row, elems[ pos ].col ) ] = pos;
+  }
+  elems.pop_back( );
+}
+
+template< class dtype >
+void SparseMatrix2D< dtype >::fill_zeros( ) {
+  elems.clear( );
+  index.clear( );
+}
+
+template< class dtype >
+dtype SparseMatrix2D< dtype >::get_elem( size_t row, size_t col ) const {
+  auto it = index.find( key( row, col ));
+  return ( it == index.end( ) ? dtype( 0 ) : elems[ it->second ].value );
+}
+
+template< class dtype >
+void SparseMatrix2D< dtype >::set_elem( size_t row, size_t col, const dtype value ) {
+  auto it = index.find( key( row, col ));
+  if ( it == index.end( )) {
+    if ( value != 0 ) {
+      index.emplace( key( row, col ), elems.size( ));
+      elems.push_back( { uint32_t( row ), uint32_t( col ), value } );
+    }
+  } else if ( value == 0 ) {
+    erase_at( it->second );
+  } else {
+    elems[ it->second ].value = value;
+  }
+}
+
+template< class dtype >
+void SparseMatrix2D< dtype >::add_elem_by( size_t row, size_t col, const dtype value ) {
+  auto it = index.find( key( row, col ));
+  if ( it == index.end( )) {
+    if ( value != 0 ) {
+      index.emplace( key( row, col ), elems.size( ));
+      elems.push_back( { uint32_t( row ), uint32_t( col ), value } );
+    }
+  } else {
+    size_t pos = it->second;
+    elems[ pos ].value += value;
+    if ( elems[ pos ].value == 0 )
+      erase_at( pos );
+  }
+}
+
+template< class dtype >
+void SparseMatrix2D< dtype >::sub_elem_by( size_t row, size_t col, const dtype value ) {
+  add_elem_by( row, col, - value );
+}
+
+template< class dtype >
+void SparseMatrix2D< dtype >::add_by( const SparseMatrix2D< dtype > &matrix_2_d ) {
+  for ( const auto &e : matrix_2_d.elems )
+    add_elem_by( e.row, e.col, e.value );
+}
+
+template< class dtype >
+void SparseMatrix2D< dtype >::sub_by( const SparseMatrix2D< dtype > &matrix_2_d ) {
+  for ( const auto &e : matrix_2_d.elems )
+    sub_elem_by( e.row, e.col, e.value );
+}
+
+template< class dtype >
+void SparseMatrix2D< dtype >::mul_by( const dtype &value ) {
+  if ( value == 0 ) {
+    fill_zeros( );
+    return;
+  }
+  for ( auto &e : elems )
+    e.value *= value;
+}
+
+template< class dtype >
+void SparseMatrix2D< dtype >::copy_from( const SparseMatrix2D< dtype > &matrix_2_d ) {
+  /* like Matrix2D::copy_from, elements out of this matrix's dimensions are dropped */
+  fill_zeros( );
+  elems.reserve( matrix_2_d.elems.size( ));
+  for ( const auto &e : matrix_2_d.elems ) {
+    if ( e.row < n_rows && e.col < n_cols ) {
+      index.emplace( key( e.row, e.col ), elems.size( ));
+      elems.push_back( e );
+    }
+  }
+}
+
+template< class dtype >
+void SparseMatrix2D< dtype >::normalize_by_max( ) {
+  dtype max_data = std::numeric_limits< dtype >::min( );
+  for ( const auto &e : elems ) {
+    if ( e.row != e.col )
+      max_data = ( max_data < e.value ? e.value : max_data );
+  }
+  if ( max_data != 0 ) {
+    for ( auto &e : elems )
+      e.value /= max_data;
+  }
+}
+
+template< class dtype >
+std::ostream &operator<<( std::ostream &os, const SparseMatrix2D< dtype > &d ) {
+  /* one "row col value" triplet per line */
+  for ( const auto &e : d.elems )
+    os << e.row << " " << e.col << " " << e.value << std::endl;
+  return os;
+}
+
+#endif //ROSTAM_SRC_UTILS_SPARSE_MATRIX_HH_
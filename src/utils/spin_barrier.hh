@@ -0,0 +1,37 @@
+#ifndef ROSTAM_SRC_UTILS_SPIN_BARRIER_HH_
+#define ROSTAM_SRC_UTILS_SPIN_BARRIER_HH_
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+/* A reusable barrier for a fixed number of threads that each run on their
+ * own core. The simulator synchronizes every step, far more often than a
+ * mutex/condition variable handoff can afford, so waiters spin (yielding)
+ * on a generation counter instead of sleeping. Everything a thread wrote
+ * before arriving is visible to all threads after they leave. */
+class SpinBarrier {
+ private:
+  const uint32_t num_threads;
+  std::atomic< uint32_t > num_arrived;
+  std::atomic< uint64_t > generation;
+
+ public:
+  explicit SpinBarrier( uint32_t num_threads ) : num_threads( num_threads ), num_arrived( 0 ), generation( 0 ) { }
+
+  SpinBarrier( const SpinBarrier & ) = delete;
+
+  SpinBarrier &operator=( const SpinBarrier & ) = delete;
+
+  void arrive_and_wait( ) {
+    const uint64_t gen = generation.load( std::memory_order_acquire );
+    if ( num_arrived.fetch_add( 1, std::memory_order_acq_rel ) + 1 == num_threads ) {
+      num_arrived.store( 0, std::memory_order_relaxed );
+      generation.fetch_add( 1, std::memory_order_release );
+    } else {
+      while ( generation.load( std::memory_order_acquire ) == gen )
+        std::this_thread::yield( );
+    }
+  }
+};
+
+#endif //ROSTAM_SRC_UTILS_SPIN_BARRIER_HH_
@@ -0,0 +1,65 @@
+#ifndef ROSTAM_SRC_UTILS_WORKER_POOL_HH_
+#define ROSTAM_SRC_UTILS_WORKER_POOL_HH_
+#include <functional>
+#include <thread>
+#include <vector>
+#include "spin_barrier.hh"
+
+/* A fixed set of threads that run one job per thread at a time, with the
+ * calling thread taking part as thread 0. Work is split statically (thread t
+ * always gets part t), so the same partition is handled by the same thread
+ * every step and the results don't depend on scheduling. */
+class WorkerPool {
+ private:
+  const size_t num_threads;
+  SpinBarrier start;
+  SpinBarrier finish;
+  const std::function< void( size_t ) > *job;
+  bool stopping;
+  std::vector< std::thread > workers;
+
+  void work( size_t part ) {
+    while ( true ) {
+      start.arrive_and_wait( );
+      if ( stopping )
+        return;
+      ( *job )( part );
+      finish.arrive_and_wait( );
+    }
+  }
+
+ public:
+  explicit WorkerPool( size_t num_threads ) : num_threads( num_threads ),
+                                              start( num_threads ),
+                                              finish( num_threads ),
+                                              job( nullptr ),
+                                              stopping( false ),
+                                              workers( ) {
+    for ( size_t part = 1; part < num_threads; part ++ )
+      workers.emplace_back( &WorkerPool::work, this, part );
+  }
+
+  WorkerPool( const WorkerPool & ) = delete;
+
+  WorkerPool &operator=( const WorkerPool & ) = delete;
+
+  ~WorkerPool( ) {
+    stopping = true;
+    start.arrive_and_wait( );
+    for ( auto &worker : workers )
+      worker.join( );
+  }
+
+  size_t size( ) const { return num_threads; }
+
+  /* run part( t ) for every t in [0, size( )) and wait for all of them */
+  void run( const std::function< void( size_t ) > &part ) {
+    job = &part;
+    start.arrive_and_wait( );
+    part( 0 );
+    finish.arrive_and_wait( );
+    job = nullptr;
+  }
+};
+
+#endif //ROSTAM_SRC_UTILS_WORKER_POOL_HH_